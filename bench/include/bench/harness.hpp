@@ -0,0 +1,95 @@
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+namespace bench
+{
+  using engine::utilities::runtime_assert;
+  using clock    = std::chrono::steady_clock;
+  using duration = std::chrono::duration<double>;
+
+  /* keeps `value` and the work producing it from being optimized out */
+  template <typename T>
+  auto inline do_not_optimize(T const &value) -> void
+  {
+#if /* */ defined(__GNUC__) or defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else  // defined(__GNUC__) or defined(__clang__)
+    auto static volatile sink = static_cast<void const *>(nullptr);
+    sink                      = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif // defined(__GNUC__) or defined(__clang__)
+  }
+
+  /* Runs each benchmark for warmup and measured repetitions and keeps per iteration statistics. */
+  struct harness
+  {
+    public:
+      struct options
+      {
+          size_t /*       */ warmup      = 2zu,
+                             repetitions = 15zu;
+          duration /*     */ min_time    = std::chrono::milliseconds{20}; /* per repetition, iterations are calibrated to reach it */
+          std::string /*  */ filter      = {};                            /* runs benchmarks whose name contains it */
+          std::filesystem::path json_path = {};                           /* stdout when empty */
+          /* --warmup=<n> --repetitions=<n> --min-time=<ms> --filter=<substring> --json=<path> */
+          auto static parse(std::span<char const *const> args) -> options;
+      };
+      struct result
+      {
+          std::string name        = {};
+          size_t /**/ iterations  = 0zu, /* per repetition */
+                      repetitions = 0zu;
+          duration    median      = {}, /* per iteration */
+                      min         = {},
+                      mean        = {},
+                      stddev      = {};
+          std::string skipped     = {}; /* reason the benchmark did not run */
+      };
+
+      /**/ /*  */ explicit harness(options config) : m_options{std::move(config)} {}
+
+      /* times `iteration()` over calibrated batches */
+      template <typename F>
+        requires(std::invocable<F &>)
+      auto inline run(std::string_view name, F &&iteration) -> void
+      {
+        if (not is_selected(name)) return;
+        auto const batch = [&](size_t iterations) -> duration
+        {
+          auto const start = clock::now();
+          for (auto i = 0zu; i < iterations; ++i)
+            if constexpr (std::is_void_v<std::invoke_result_t<F &>>) std::invoke(iteration);
+            else do_not_optimize(std::invoke(iteration));
+          return clock::now() - start;
+        };
+        auto iterations = 1zu;
+        for (auto elapsed = batch(iterations); elapsed < m_options.min_time and iterations < (1zu << 30u); elapsed = batch(iterations))
+          iterations *= elapsed.count() > 0.0 ? std::clamp(static_cast<size_t>(m_options.min_time / elapsed * 1.2) + 1zu, 2zu, 16zu) : 16zu;
+        record(name, iterations, [&] { return batch(iterations); });
+      }
+      /* one sample per call of `repetition`, which measures itself and returns the time of `iterations` iterations */
+      template <typename F>
+        requires(std::is_invocable_r_v<duration, F &>)
+      auto inline run_samples(std::string_view name, size_t iterations, F &&repetition) -> void
+      {
+        if (not is_selected(name)) return;
+        record(name, iterations, repetition);
+      }
+      auto /*  */ skip(std::string_view name, std::string_view reason) -> void;
+
+      auto /*  */ write_json() const -> void;
+      auto inline get_results() const noexcept -> std::span<result const> { return m_results; }
+
+    private:
+      auto /*  */ is_selected(std::string_view name) const -> bool;
+      auto /*  */ record(std::string_view name, size_t iterations, std::function<duration()> const &repetition) -> void;
+
+      options /*       */ m_options = {};
+      std::vector<result> m_results = {};
+  };
+} // namespace bench
+
+#endif // BENCH_HARNESS_HPP
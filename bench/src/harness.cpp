@@ -0,0 +1,82 @@
+#include <bench/harness.hpp>
+
+auto bench::harness::options::parse(std::span<char const *const> args) -> options
+{
+  auto const parse_number = [](std::string_view name, std::string_view value) static -> size_t
+  {
+    auto number            = size_t{};
+    auto const [end, code] = std::from_chars(value.data(), value.data() + value.size(), number);
+    runtime_assert<std::invalid_argument>(code == std::errc{} and end == value.data() + value.size(), "invalid {} {:?}", name, value);
+    return number;
+  };
+  auto result = options{};
+  for (auto const argument : args | std::views::drop(1) | std::views::transform([](char const *arg) static { return std::string_view{arg}; }))
+  {
+    auto const split = argument.find('=');
+    auto const key   = argument.substr(0zu, split);
+    auto const value = split == std::string_view::npos ? std::string_view{} : argument.substr(split + 1zu);
+    if /*   */ (key == "--warmup") result.warmup = parse_number("warmup count", value);
+    else if (key == "--repetitions") result.repetitions = runtime_assert<std::invalid_argument>(parse_number("repetition count", value), "{} must be positive", "repetition count");
+    else if (key == "--min-time") result.min_time = std::chrono::milliseconds{parse_number("min time", value)};
+    else if (key == "--filter") result.filter = value;
+    else if (key == "--json") result.json_path = value;
+    else runtime_assert<std::invalid_argument>(false, "unknown option {:?}", argument);
+  }
+  return result;
+}
+auto bench::harness::skip(std::string_view name, std::string_view reason) -> void
+{
+  if (not is_selected(name)) return;
+  std::println(stderr, "{:<40} skipped: {}", name, reason);
+  m_results.push_back({.name = std::string{name}, .skipped = std::string{reason}});
+}
+auto bench::harness::is_selected(std::string_view name) const -> bool
+{
+  return name.contains(m_options.filter);
+}
+auto bench::harness::record(std::string_view name, size_t iterations, std::function<duration()> const &repetition) -> void
+{
+  for ([[maybe_unused]] auto const warmup : std::views::iota(0zu, m_options.warmup)) repetition();
+  auto samples = std::vector<double>{};
+  samples.reserve(m_options.repetitions);
+  for ([[maybe_unused]] auto const repetition_index : std::views::iota(0zu, m_options.repetitions))
+    samples.push_back(repetition().count() / static_cast<double>(iterations));
+  std::ranges::sort(samples);
+  auto const count    = static_cast<double>(samples.size());
+  auto const mean     = std::ranges::fold_left(samples, 0.0, std::plus{}) / count;
+  auto const variance = std::ranges::fold_left(samples | std::views::transform([mean](double sample) { return (sample - mean) * (sample - mean); }), 0.0, std::plus{}) / count;
+  auto const middle   = samples.size() / 2zu;
+  auto const median   = samples.size() % 2zu ? samples[middle] : (samples[middle - 1zu] + samples[middle]) / 2.0;
+  auto const &value   = m_results.emplace_back(result{
+      .name        = std::string{name},
+      .iterations  = iterations,
+      .repetitions = samples.size(),
+      .median      = duration{median},
+      .min         = duration{samples.front()},
+      .mean        = duration{mean},
+      .stddev      = duration{std::sqrt(variance)},
+  });
+  auto const ns = [](duration value) static { return 1e9 * value.count(); };
+  std::println(stderr, "{:<40} median {:>14.1f} ns  min {:>14.1f} ns  stddev {:>6.2f}%  ({} x {})", value.name, ns(value.median), ns(value.min),
+               value.mean.count() > 0.0 ? 100.0 * value.stddev / value.mean : 0.0, value.repetitions, value.iterations);
+}
+auto bench::harness::write_json() const -> void
+{
+  auto json = std::string{"{\"benchmarks\":["};
+  for (auto const [i, value] : std::views::enumerate(m_results))
+  {
+    if (i) json += ',';
+    if (not value.skipped.empty())
+    {
+      std::format_to(std::back_inserter(json), "{{\"name\":{:?},\"skipped\":{:?}}}", value.name, value.skipped);
+      continue;
+    }
+    std::format_to(std::back_inserter(json), "{{\"name\":{:?},\"iterations\":{},\"repetitions\":{},\"median_ns\":{:.3f},\"min_ns\":{:.3f},\"mean_ns\":{:.3f},\"stddev_ns\":{:.3f}}}",
+                   value.name, value.iterations, value.repetitions, 1e9 * value.median.count(), 1e9 * value.min.count(), 1e9 * value.mean.count(), 1e9 * value.stddev.count());
+  }
+  json += "]}";
+  if (m_options.json_path.empty()) return std::println("{}", json);
+  auto file = std::ofstream{m_options.json_path};
+  runtime_assert(file.is_open(), "Failed to open {} for writing", m_options.json_path.string());
+  std::println(file, "{}", json);
+}
@@ -0,0 +1,156 @@
+#include <bench/harness.hpp>
+#include <engine/application.hpp>
+#include <engine/renderer.hpp>
+#include <game/game.hpp>
+#include <game/simulations.hpp>
+
+namespace
+{
+  auto constinit s_next_name = uint32_t{0u};
+  /* hands out increasing names without a gl context, so the cache bookkeeping is all that is measured */
+  auto constexpr s_fake_names = engine::renderer::handle_cache::allocator{
+      .create_handles = +[](std::span<uint32_t> target) static noexcept -> void
+      { for (auto &name : target) name = ++s_next_name; },
+      .delete_handles = +[](std::span<uint32_t> target) static noexcept -> void { (void)target; },
+  };
+
+  auto heap_sort_partial(bench::harness &harness) -> void
+  {
+    for (auto const [size, n] : {std::pair{1'024zu, 16zu}, std::pair{4'096zu, 64zu}, std::pair{4'096zu, 4'096zu}})
+    {
+      auto random = std::mt19937{static_cast<uint32_t>(size)};
+      auto input  = std::vector<float>(size);
+      for (auto &value : input) value = std::uniform_real_distribution{0.0f, 1.0f}(random);
+      auto work = input;
+      harness.run(std::format("heap_sort_partial/{}/{}", size, n),
+                  [&]
+                  {
+                    std::ranges::copy(input, work.begin()); /* included, sorting in place needs a fresh input */
+                    auto const [unsorted, sorted] = engine::utilities::heap_sort_partial(std::span{work}, n);
+                    return sorted.front();
+                  });
+    }
+  }
+  auto handle_cache(bench::harness &harness) -> void
+  {
+    auto cache = engine::renderer::handle_cache{&s_fake_names};
+    cache.reserve(64zu);
+    harness.run("handle_cache/activate_deactivate", [&] { cache.deactivate(cache.activate()); });
+    auto names = std::array<uint32_t, 64zu>{};
+    harness.run("handle_cache/activate_deactivate/64",
+                [&]
+                {
+                  for (auto &name : names) name = cache.activate();
+                  for (auto const name : names) cache.deactivate(name);
+                });
+  }
+  auto print_ansi_table(bench::harness &harness) -> void
+  {
+#if /* */ defined(_WIN32)
+    auto const null_path = "NUL";
+#else  // defined(_WIN32)
+    auto const null_path = "/dev/null";
+#endif // defined(_WIN32)
+    auto const null_stream = std::unique_ptr<std::FILE, decltype([](std::FILE *p) static { return std::fclose(p); })>{std::fopen(null_path, "w")};
+    if (not null_stream) return harness.skip("print_ansi_table/8", std::format("could not open {}", null_path));
+    harness.run("print_ansi_table/8",
+                [&]
+                {
+                  engine::utilities::print_ansi_table({
+                                                          {"frame p50  ms", 16.667},
+                                                          {"frame p90  ms", 17.012},
+                                                          {"frame p99  ms", 21.384},
+                                                          {"render p99 ms", 3.141},
+                                                          {" pacer misses", 12zu},
+                                                          {" posted drops", -1},
+                                                          {"        title", "Engine"},
+                                                          {" render scale", 0.75},
+                                                      },
+                                                      null_stream.get());
+                });
+  }
+  auto read_all(bench::harness &harness) -> void
+  {
+    auto constexpr size      = 64zu * 1024zu * 1024zu;
+    auto constexpr page_size = 4'096zu;
+    auto const file_path     = std::filesystem::temp_directory_path() / std::format("engine-bench-{}.bin", std::random_device{}());
+    auto const remove_file   = std::unique_ptr<std::filesystem::path const, decltype([](std::filesystem::path const *p) static
+                                                                                   { std::error_code ignored; (void)std::filesystem::remove(*p, ignored); })>{&file_path};
+    if (auto file = std::ofstream{file_path, std::ios::binary})
+    {
+      auto page = std::vector<char>(page_size);
+      std::ranges::generate(page, [i = 0u] mutable { return static_cast<char>(i++ * 31u); });
+      for ([[maybe_unused]] auto const page_index : std::views::iota(0zu, size / page_size)) file.write(page.data(), static_cast<std::streamsize>(page.size()));
+    }
+    if (std::error_code error; std::filesystem::file_size(file_path, error) != size) return harness.skip("read_all/64MiB", "could not write the temporary file");
+    auto const checksum = [](std::span<std::byte const> bytes) static /* touches every page */
+    {
+      auto sum = 0u;
+      for (auto i = 0zu; i < bytes.size(); i += page_size) sum += std::to_integer<uint32_t>(bytes[i]);
+      return sum;
+    };
+    harness.run("read_all/64MiB",
+                [&]
+                {
+                  auto const contents = runtime_assert(engine::utilities::read_all(file_path, "rb"), "read failed");
+                  return checksum(std::as_bytes(std::span{*contents}));
+                });
+    harness.run("mapped_file/64MiB", [&] { return checksum(runtime_assert(engine::utilities::mapped_file::open(file_path), "open failed")->bytes()); });
+  }
+  auto boids_step(bench::harness &harness) -> void
+  {
+    for (auto const boid_count : {200zu, 800zu, 3'200zu, 9'600zu})
+    {
+      auto simulation = game::simulations::boids{{.boid_count = boid_count}, /* seed */ 0u};
+      for ([[maybe_unused]] auto const tick : std::views::iota(0, 60)) simulation.step({10.0f, 10.0f}); /* spawn and let the flock settle */
+      harness.run(std::format("boids_step/{}", boid_count), [&] { return simulation.step({10.0f, 10.0f}).total_neighbors; });
+    }
+  }
+  /* whole application runs, each sample is the median layer update of one run. the update only records gpu work, it is not waited on */
+  auto life_step(bench::harness &harness) -> void
+  {
+    using backend_t = engine::application::options::backend_t;
+    for (auto const [name, backend] : {std::pair{std::string_view{"headless"}, backend_t::headless}, std::pair{std::string_view{"no_render"}, backend_t::no_render}})
+    {
+      auto const benchmark_name = std::format("life_step/{}", name);
+      auto const run_once       = [backend]() -> bench::duration
+      {
+        auto app = engine::application{{
+            .backend      = backend,
+            .size         = {128, 128},
+            .max_ticks    = 15zu,
+            .stats_format = engine::utilities::stats_sink::format::none,
+        }};
+        game::layers::push_layer("game_of_life", false, app);
+        app.run();
+        auto const report = app.get_metrics().get_report();
+        auto const update = std::ranges::find_if(report.histograms, [](auto const &histogram) static
+                                                 { return histogram.first.starts_with("layer update") and histogram.first.ends_with("game_of_life"); });
+        runtime_assert(update != report.histograms.end(), "no {} layer updates", "game_of_life");
+        return update->second.p50;
+      };
+      try
+      {
+        run_once(); /* fails early where no context can be made */
+      }
+      catch (std::exception const &e)
+      {
+        harness.skip(benchmark_name, e.what());
+        continue;
+      }
+      harness.run_samples(benchmark_name, 1zu, run_once);
+    }
+  }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  auto harness = bench::harness{bench::harness::options::parse({argv, static_cast<size_t>(argc)})};
+  heap_sort_partial(harness);
+  handle_cache(harness);
+  print_ansi_table(harness);
+  read_all(harness);
+  boids_step(harness);
+  life_step(harness);
+  harness.write_json();
+}
@@ -0,0 +1,71 @@
+#ifndef ENGINE_ALLOCATION_TRACKER_HPP
+#define ENGINE_ALLOCATION_TRACKER_HPP
+
+#include <engine/core.hpp>
+
+namespace engine::allocation_tracker
+{
+  enum class phase : uint8_t
+  {
+    other, /* outside the phases below, or on another thread */
+    layer_tasks,
+    events,
+    update,
+    render,
+  };
+  auto inline constexpr s_phase_count = 5zu;
+  auto inline constexpr s_phase_names = std::array<std::string_view, s_phase_count>{"other", "layer tasks", "events", "update", "render"};
+  auto inline constexpr s_layer_slots = 64zu; /* distinct layer types tracked, the rest count as the first slot */
+  struct counters
+  {
+      uint64_t allocations   = 0u,
+               deallocations = 0u,
+               bytes         = 0u; /* requested by allocations */
+  };
+  struct frame_report /* fixed size so taking one does not allocate */
+  {
+      std::array<counters, s_phase_count> /*                                */ phases      = {};
+      std::array<bool, s_phase_count> /*                                    */ violations  = {}; /* allocation free phases that allocated */
+      std::array<std::pair<char const * /* layer */, counters>, s_layer_slots> layers      = {}; /* the first `layer_count` allocated or freed */
+      size_t /*                                                             */ layer_count = 0zu;
+  };
+
+#if /* */ defined(ENGINE_ALLOCATION_TRACKER)
+  auto inline constexpr enabled = true;
+  auto /*  */ set_phase(phase value) noexcept -> phase; /* for the calling thread, returns the previous one */
+  auto /*  */ set_layer(char const *name) noexcept -> char const *; /* `typeid` names or literals, nullptr for none */
+  auto /*  */ set_allocation_free(phase value, bool allocation_free) noexcept -> void;
+  auto /*  */ end_frame() -> frame_report; /* counts since the previous call, resets them */
+#else  // defined(ENGINE_ALLOCATION_TRACKER)
+  auto inline constexpr enabled = false;
+  auto inline set_phase(phase value) noexcept -> phase { return (void)value, phase::other; }
+  auto inline set_layer(char const *name) noexcept -> char const * { return (void)name, nullptr; }
+  auto inline set_allocation_free(phase value, bool allocation_free) noexcept -> void { (void)value, (void)allocation_free; }
+  auto inline end_frame() -> frame_report { return {}; }
+#endif // defined(ENGINE_ALLOCATION_TRACKER)
+
+  struct phase_scope
+  {
+    public:
+      /**/ inline phase_scope(phase value) noexcept : m_previous{set_phase(value)} {}
+      /**/ inline ~phase_scope() noexcept { set_phase(m_previous); }
+      /**/ inline phase_scope(phase_scope const &) = delete;
+      auto inline operator=(phase_scope const &) -> phase_scope & = delete;
+
+    private:
+      phase m_previous;
+  };
+  struct layer_scope
+  {
+    public:
+      /**/ inline layer_scope(char const *name) noexcept : m_previous{set_layer(name)} {}
+      /**/ inline ~layer_scope() noexcept { set_layer(m_previous); }
+      /**/ inline layer_scope(layer_scope const &) = delete;
+      auto inline operator=(layer_scope const &) -> layer_scope & = delete;
+
+    private:
+      char const *m_previous;
+  };
+} // namespace engine::allocation_tracker
+
+#endif // ENGINE_ALLOCATION_TRACKER_HPP
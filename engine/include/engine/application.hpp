@@ -1,8 +1,19 @@
 #ifndef ENGINE_APPLICATION_HPP
 #define ENGINE_APPLICATION_HPP
 
+#include <engine/allocation_tracker.hpp>
 #include <engine/core.hpp>
+#include <engine/event_log.hpp>
+#include <engine/file_loader.hpp>
+#include <engine/frame_pacer.hpp>
+#include <engine/input_state.hpp>
+#include <engine/metrics.hpp>
+#include <engine/mpsc_queue.hpp>
+#include <engine/render_target.hpp>
 #include <engine/renderer.hpp>
+#include <engine/stats_sink.hpp>
+#include <engine/task.hpp>
+#include <engine/timer_wheel.hpp>
 #include <engine/utilities.hpp>
 
 #include <GLFW/glfw3.h>
@@ -22,45 +33,88 @@ namespace engine
           auto virtual on_event(std::any const &event_any) -> void { (void)event_any; }
           auto virtual on_update() -> update_delay { return update_delay::max(); }
           auto virtual on_render() -> void {}
+          /* whether the output of `on_render` changed since it was last called. frames where no layer is dirty are skipped */
+          auto virtual is_dirty() const -> bool { return true; }
 
         protected:
           auto inline static app() -> application & { return application::get(); }
+
+        private:
+          friend application;
+          uint32_t m_update_slot = std::numeric_limits<uint32_t>::max(); /* in the update schedule, validated against the layer before use */
+      };
+      struct options
+      {
+          enum class backend_t : uint8_t
+          {
+            window,    /* a visible glfw window */
+            headless,  /* glfw null platform with an egl surfaceless context, frames render to an offscreen framebuffer */
+            no_render, /* like headless, the context stays for layer setup and gpu updates but the render phase is skipped */
+          };
+          backend_t /*       */ backend    = backend_t::window;
+          glm::ivec2 /*      */ size       = {720, 720};
+          std::optional<size_t> max_frames = {}, /* main loop iterations before `run` returns */
+                                max_ticks  = {}; /* layer updates before `run` returns */
+          std::filesystem::path trace_path = {}; /* chrome trace written when `run` returns, needs ENGINE_ENABLE_PROFILER */
+          utilities::stats_sink::format
+              /*             */ stats_format = utilities::stats_sink::format::ansi_table;
+          std::filesystem::path stats_path   = {}; /* stdout when empty */
+          viewport_fit /*    */ fit              = viewport_fit::cover;
+          double /*          */ min_render_scale = render_target::s_default_scale; /* 1 renders at full resolution always */
+          std::filesystem::path capture_path     = {}; /* presented frames, a .y4m file or else a directory of pngs */
+          std::filesystem::path record_path      = {}; /* event log of the glfw events dispatched to layers */
+          std::filesystem::path replay_path      = {}; /* event log replayed in place of the glfw events, its seed overrides `seed` */
+          std::optional<uint64_t> seed           = {}; /* random when empty */
+          std::optional<utilities::gl::check_level>
+              /*             */ gl_check = {}; /* per_call in debug builds and off with NDEBUG when empty, capped by ENGINE_GL_CHECK_LEVEL */
+          std::array<bool, allocation_tracker::s_phase_count>
+              /*             */ allocation_free = {}; /* phases reported and counted as errors when they allocate, needs ENGINE_ENABLE_ALLOCATION_TRACKER */
+          /* --backend=window|headless|no_render --size=<width>x<height> --frames=<n> --ticks=<n> --trace=<path>
+             --stats=ansi|csv|jsonl|none --stats-file=<path> --allocation-free=<phase>[,<phase>...]
+             --viewport-fit=cover|contain|stretch --render-scale=<lowest scale in (0, 1]> --capture=<file.y4m|directory>
+             --record=<path> --replay=<path> --seed=<n> --gl-check=off|per_frame|per_call */
+          auto static parse(std::span<char const *const> args) -> options;
       };
       using layers_t          = std::vector<std::shared_ptr<layer_t>>;
       using layers_task_t     = std::function<void(layers_t &layers)>;
       using event_container_t = std::any;
 
     private:
-      auto inline static constinit s_instance = static_cast<application *>(nullptr);
-      using layer_update_appointment_t        = struct layer_update_appointment
+      auto inline static constinit s_instance                 = static_cast<application *>(nullptr);
+      auto inline static constexpr s_allocation_warmup_frames = 60zu; /* caches and arenas settle before allocation free phases are enforced */
+      auto inline static constexpr s_never_update             = std::chrono::hours{24 * 365}; /* update delays from here on unschedule the layer */
+      auto inline static constexpr s_posted_event_capacity    = 1024zu;
+      struct scheduled_layer
+      {
+          layer_t *layer = {}; /* scheduled on push and cancelled on pop, only compared while reconciling arbitrary manipulations */
+      };
+      using layer_update_schedule_t = utilities::timer_wheel<scheduled_layer>;
+      using event_queue_t           = std::pmr::vector<event_container_t>;
+      struct layer_metrics
       {
-          clock::time_point      appointment                      = {};
-          size_t                 render_index_for_stable_ordering = {};
-          std::weak_ptr<layer_t> layer                            = {};
-          auto inline constexpr ordering() const noexcept { return std::tuple{appointment, render_index_for_stable_ordering}; }
-          auto inline constexpr operator<=>(layer_update_appointment const &o) const noexcept { return ordering() <=> o.ordering(); }
+          utilities::metrics::histogram *update = nullptr,
+                                        *render = nullptr;
       };
-      using layer_update_schedule_t = std::priority_queue<layer_update_appointment_t,
-                                                          std::vector<layer_update_appointment_t>,
-                                                          std::greater<layer_update_appointment_t>>;
-      using event_queue_t           = std::vector<event_container_t>;
 
     public:
       /**/ /*  */ application();
+      /**/ /*  */ explicit application(options const &config);
       /**/ /*  */ ~application();
 
+      /* arbitrary changes, the update schedule is reconciled against the whole stack afterwards */
       template <typename T>
         requires(std::convertible_to<T, layers_task_t>)
       auto inline schedule_layer_manipulation(T &&task) -> void
       {
-        m_layers_tasks.emplace_back(std::forward<T>(task));
+        m_layers_tasks.emplace_back([this, task = layers_task_t{std::forward<T>(task)}](layers_t &layers)
+                                    { task(layers), reconcile_layer_updates(); });
       }
       template <typename T>
         requires(std::invocable<T> and std::convertible_to<std::invoke_result_t<T>, std::shared_ptr<layer_t>>)
       auto inline schedule_layer_push(T &&make_layer, std::ptrdiff_t index = -1) -> void
       {
-        schedule_layer_manipulation(
-            [make_layer = std::forward<T>(make_layer), index](layers_t &layers) mutable
+        m_layers_tasks.emplace_back(
+            [this, make_layer = std::forward<T>(make_layer), index](layers_t &layers) mutable
             {
               auto layer = static_cast<std::shared_ptr<layer_t>>(std::invoke(make_layer));
               runtime_assert<std::logic_error>(layer, "attempt to push nullptr to layer stack");
@@ -68,7 +122,7 @@ namespace engine
               auto const layers_size = static_cast<ptrdiff_t>(layers.size());
               auto const i           = index < 0 ? index + layers_size + 1 : index;
               runtime_assert<std::out_of_range>(0 <= i and i <= layers_size, "out of range");
-              layers.emplace(layers.begin() + i, std::move(layer));
+              schedule_layer_update(**layers.emplace(layers.begin() + i, std::move(layer)));
             });
       }
       template <typename T, typename... Args>
@@ -94,10 +148,36 @@ namespace engine
       {
         return queue_event<std::remove_cvref_t<T>, T>(std::forward<T>(event));
       }
+      /* thread safe `queue_event`, wakes the main loop. fails and counts a drop when the queue is full */
+      template <typename T, typename... Args>
+        requires(std::constructible_from<T, Args...>)
+      auto inline post_event(Args &&...args) -> bool
+      {
+        if (not m_posted_events.try_push(std::in_place_type<T>, std::forward<Args>(args)...)) return false;
+        return glfwPostEmptyEvent(), true;
+      }
+      template <typename T>
+      auto inline post_event(T &&event) -> bool
+      {
+        return post_event<std::remove_cvref_t<T>, T>(std::forward<T>(event));
+      }
 
       auto inline get_window /*               */ () const /*    */ -> auto /* */ & { return *runtime_assert(m_window, "null {} access", "main window"); }
       auto inline get_renderer /*             */ () const noexcept -> auto /* */ & { return m_renderer; }
       auto inline get_renderer /*             */ () /* */ noexcept -> auto /* */ & { return m_renderer; }
+      auto inline get_frame_pacer /*          */ () const noexcept -> auto const & { return m_frame_pacer; }
+      auto inline get_options /*              */ () const noexcept -> auto const & { return m_options; }
+      auto inline get_input /*                */ () const noexcept -> input_state const & { return m_input; }
+      /* layers seed their random engines from here so recorded runs replay deterministically */
+      auto inline get_seed /*                 */ () const noexcept -> uint64_t { return m_seed; }
+      auto inline get_render_target /*        */ () const noexcept -> render_target const & { return m_render_target; }
+      auto inline get_file_loader /*          */ () /* */ noexcept -> utilities::file_loader & { return m_file_loader; }
+      auto inline get_coroutines /*           */ () /* */ noexcept -> coroutine_scheduler & { return m_coroutines; }
+      auto inline get_stats /*                */ () /* */ noexcept -> auto /* */ & { return m_stats; }
+      auto inline get_metrics /*              */ () /* */ noexcept -> auto /* */ & { return m_metrics; }
+      /* scratch memory valid until the end of the next frame */
+      auto inline get_frame_resource /*       */ () /* */ noexcept -> std::pmr::memory_resource * { return m_frame_arena.get_resource(); }
+      auto inline get_allocation_report /*    */ () const noexcept -> auto const & { return m_allocation_report; }
       auto inline get_layers /*               */ () const noexcept -> auto /*   */ { return std::span{m_layers}; }
       auto inline get_target_render_period /* */ () const noexcept -> auto /*   */ { return /* */ m_target_render_period.count(); }
       auto inline get_target_render_rate /*   */ () const noexcept -> auto /*   */ { return 1.0 / m_target_render_period.count(); }
@@ -105,18 +185,67 @@ namespace engine
       auto inline set_target_render_period /* */ (double value) /* */ noexcept -> auto const & { return m_target_render_period = /* */ value * std::chrono::seconds(1); }
       auto inline set_target_render_rate /*   */ (double value) /* */ noexcept -> auto const & { return m_target_render_period = 1.0 / value * std::chrono::seconds(1); }
 
+      auto /*  */ set_frame_pacing_mode(frame_pacer::mode value) -> void;
+      auto /*  */ set_viewport_fit(viewport_fit value) -> void;
+      auto inline request_redraw() noexcept -> void { m_redraw_requested = true; }
+
+      /* coroutines resumed by the main loop between events and layer updates */
+      auto inline spawn /*          */ (task<void> value) -> void { m_coroutines.spawn(std::move(value)); }
+      auto inline next_frame /*     */ () noexcept { return m_coroutines.next_frame(); }
+      auto inline delay /*          */ (std::chrono::duration<double> value) noexcept { return m_coroutines.delay(value); }
+      auto inline gpu_fence /*      */ (GLsync sync) noexcept { return m_coroutines.gpu_fence(sync); }
+      template <typename F>
+        requires(std::invocable<F &>)
+      auto inline on_worker_pool /* */ (F &&job) { return m_coroutines.on_worker_pool(std::forward<F>(job)); }
+
       auto /*  */ run() -> int;
 
     private:
+      options                       m_options               = {};
+      utilities::frame_arena        m_frame_arena           = {}; /* declared before the containers using it */
+      utilities::stats_sink         m_stats                 = {};
+      utilities::metrics            m_metrics               = {};
+      utilities::file_loader        m_file_loader           = {};
+      coroutine_scheduler           m_coroutines            = {};
       GLFWwindow                   *m_window                = {};
+      input_state                   m_input                 = {};
       renderer                      m_renderer              = {};
+      renderer::handle_cache::unique_handle
+          /*                     */ m_offscreen_framebuffer = {},
+                                    m_offscreen_color       = {};
+      render_target                 m_render_target         = {};
       layers_t                      m_layers                = {};
       layer_update_schedule_t       m_layer_update_schedule = {};
-      event_queue_t                 m_events                = {};
-      event_queue_t                 m_events_swap           = {};
-      std::vector<layers_task_t>    m_layers_tasks          = {};
+      event_queue_t                 m_events                = event_queue_t{m_frame_arena.get_resource()};
+      utilities::mpsc_queue<event_container_t>
+          /*                     */ m_posted_events         = utilities::mpsc_queue<event_container_t>{s_posted_event_capacity};
+      uint64_t                      m_seed                  = 0u;
+      std::optional<event_log::recorder>
+          /*                     */ m_recorder              = {};
+      std::optional<event_log::player>
+          /*                     */ m_player                = {};
+      std::pmr::vector<layers_task_t>
+          /*                     */ m_layers_tasks          = std::pmr::vector<layers_task_t>{m_frame_arena.get_resource()};
       std::chrono::duration<double> m_target_render_period  = std::chrono::seconds(1) * 1.0 / 60.0;
       clock::time_point             m_render_appointment    = clock::now();
+      frame_pacer                   m_frame_pacer           = {};
+      bool                          m_redraw_requested      = true;
+      size_t                        m_frame_count           = 0zu,
+                                    m_tick_count            = 0zu;
+      std::unordered_map<std::type_index, layer_metrics>
+          /*                     */ m_layer_metrics         = {};
+      allocation_tracker::frame_report
+          /*                     */ m_allocation_report     = {}; /* of the last frame */
+
+      auto /*  */ get_layer_metrics(layer_t const &layer) -> layer_metrics const &;
+      auto /*  */ has_layer_update(layer_t const &layer) const -> bool;
+      auto /*  */ schedule_layer_update(layer_t &layer) -> void; /* due right away */
+      auto /*  */ cancel_layer_update(layer_t &layer) -> void;
+      auto /*  */ reconcile_layer_updates() -> void;
+      auto /*  */ fit_viewport() -> void;
+      template <typename T>
+      auto /*  */ glfw_event(T &&event) -> void; /* from glfw callbacks, dropped while replaying */
+      auto /*  */ apply_input(event_container_t const &event) -> void; /* folds the event into `m_input` */
   };
   auto startup(application &app) -> void;
 } // namespace engine
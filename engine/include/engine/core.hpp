@@ -4,9 +4,13 @@
 #include <algorithm>
 #include <any>
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <bit>
+#include <charconv>
 #include <chrono>
 #include <concepts>
+#include <coroutine>
 #include <expected>
 #include <filesystem>
 #include <fstream>
@@ -14,6 +18,7 @@
 #include <map>
 #include <memory>
 #include <memory_resource>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <print>
@@ -25,6 +30,7 @@
 #include <span>
 #include <stack>
 #include <thread>
+#include <typeindex>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -0,0 +1,69 @@
+#ifndef ENGINE_EVENT_LOG_HPP
+#define ENGINE_EVENT_LOG_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+#include <GLFW/glfw3.h>
+
+namespace engine
+{
+  /* Compact binary log of the `events::glfw` stream, each event tagged with the frame and tick it was dispatched on. */
+  struct event_log
+  {
+    public:
+      auto inline static constexpr s_magic   = std::array{'E', 'V', 'E', 'N', 'T', 'L', 'O', 'G'};
+      auto inline static constexpr s_version = 1u;
+
+      struct recorder
+      {
+        public:
+          auto inline static constexpr s_flush_size = 64zu * 1024zu;
+
+          /**/ /*  */ recorder(std::filesystem::path const &file_path, uint64_t seed);
+          /**/ inline recorder(recorder const &)            = delete;
+          auto inline operator=(recorder const &) -> recorder & = delete;
+          /**/ /*  */ ~recorder(); /* flushes */
+
+          auto /*  */ write(uint64_t frame, uint64_t tick, std::any const &event) -> bool; /* false for anything but glfw events */
+          auto /*  */ flush() -> void;
+          auto inline get_count() const noexcept -> uint64_t { return m_count; }
+
+        private:
+          std::ofstream /*     */ m_file   = {};
+          std::vector<uint8_t> m_buffer = {};
+          uint64_t /*          */ m_frame  = 0u,
+                                  m_tick   = 0u,
+                                  m_count  = 0u;
+      };
+      struct player
+      {
+        public:
+          /**/ /*  */ player(std::filesystem::path const &file_path, GLFWwindow *window); /* replayed events point at `window` */
+          /**/ inline player(player const &)            = delete;
+          auto inline operator=(player const &) -> player & = delete;
+
+          /* the next event once both its recorded frame and tick are reached */
+          auto /*  */ next(uint64_t frame, uint64_t tick) -> std::optional<std::any>;
+          /* tick of the next event, updates past it would run ahead of the recording */
+          auto /*  */ get_next_tick() -> std::optional<uint64_t>;
+          auto inline get_seed /*        */ () const noexcept -> uint64_t { return m_seed; }
+          auto inline is_done /*         */ () const noexcept -> bool { return not m_peeked and m_offset == m_file.size(); }
+          auto inline get_count /*       */ () const noexcept -> uint64_t { return m_count; }
+          auto inline get_late_frames /* */ () const noexcept -> uint64_t { return m_late_frames; } /* events replayed on a later frame than recorded */
+
+        private:
+          utilities::mapped_file m_file        = {};
+          GLFWwindow /*       */ *m_window      = {};
+          size_t /*              */ m_offset      = 0zu;
+          uint64_t /*            */ m_seed        = 0u,
+                                    m_frame       = 0u, /* of the next event */
+                                    m_tick        = 0u,
+                                    m_count       = 0u,
+                                    m_late_frames = 0u;
+          bool /*                */ m_peeked      = false; /* frame and tick of the next event are decoded */
+      };
+  };
+} // namespace engine
+
+#endif // ENGINE_EVENT_LOG_HPP
@@ -0,0 +1,51 @@
+#ifndef ENGINE_FILE_LOADER_HPP
+#define ENGINE_FILE_LOADER_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+
+namespace engine::utilities
+{
+  /* Opens files on a background io thread. Results are polled from the main loop through futures. */
+  struct file_loader
+  {
+    public:
+      using result_t = std::expected<mapped_file, std::error_code>;
+
+      /**/ /*  */ file_loader();
+      /**/ /*  */ ~file_loader(); /* pending loads are completed before returning */
+      /**/ inline file_loader(file_loader const &)            = delete;
+      auto inline operator=(file_loader const &) -> file_loader & = delete;
+
+      auto /*  */ load(std::filesystem::path file_path) -> std::future<result_t>;
+      auto /*  */ poll() -> void; /* loads on targets without worker threads, no-op otherwise */
+      auto /*  */ get_pending() -> size_t;
+
+      template <typename T>
+      auto inline static is_ready(std::future<T> const &future) -> bool
+      {
+        return future.valid() and future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+      }
+
+    private:
+      struct request
+      {
+          std::filesystem::path    file_path = {};
+          std::promise<result_t> promise   = {};
+      };
+      auto static complete(request &request) -> void;
+
+      std::mutex /*             */ m_mutex    = {};
+      std::deque<request> /*    */ m_requests = {};
+#if /* */ not defined(__EMSCRIPTEN__)
+      std::condition_variable_any m_wake     = {};
+      std::jthread /*           */ m_thread   = {}; /* declared last, joined before the rest is destroyed */
+#endif // not defined(__EMSCRIPTEN__)
+  };
+} // namespace engine::utilities
+
+#endif // ENGINE_FILE_LOADER_HPP
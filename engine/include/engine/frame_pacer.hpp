@@ -0,0 +1,57 @@
+#ifndef ENGINE_FRAME_PACER_HPP
+#define ENGINE_FRAME_PACER_HPP
+
+#include <engine/core.hpp>
+
+namespace engine
+{
+  /* Waits for deadlines by sleeping until a learned margin before them and spinning the rest. */
+  struct frame_pacer
+  {
+    public:
+      using clock    = std::chrono::steady_clock;
+      using duration = std::chrono::duration<double>;
+      enum class mode : uint8_t
+      {
+        sleep_spin, /* every wait is paced by the cpu */
+        vsync,      /* render waits are left to `glfwSwapBuffers` with a swap interval of 1 */
+      };
+      struct histogram
+      {
+          auto inline static constexpr s_bucket_count = 20zu; /* bucket i counts samples below 2^i microseconds */
+          std::array<uint64_t, s_bucket_count> buckets = {};
+          uint64_t /*                       */ count   = 0u;
+          duration /*                       */ max     = {};
+          auto /*  */ record(duration value) noexcept -> void;
+          auto inline static constexpr bucket_upper_bound(size_t i) noexcept -> duration { return std::chrono::microseconds{1ll << i}; }
+      };
+      struct statistics
+      {
+          histogram jitter          = {}; /* how late each wait returned */
+          histogram overshoot       = {}; /* how far past its target the sleep part returned */
+          uint64_t  waits           = 0u,
+                    deadline_misses = 0u;
+      };
+      auto inline static constexpr s_miss_threshold = duration{std::chrono::microseconds{500}};
+      auto inline static constexpr s_min_margin     = duration{std::chrono::microseconds{50}};
+      auto inline static constexpr s_max_margin     = duration{std::chrono::milliseconds{4}};
+
+      auto /*  */ wait_until(clock::time_point deadline) -> void;
+      auto inline set_mode /*       */ (mode value) noexcept -> void { m_mode = value; }
+      auto inline get_mode /*       */ () const noexcept -> mode { return m_mode; }
+      auto inline get_margin /*     */ () const noexcept -> duration { return m_margin; }
+      auto inline get_statistics /* */ () const noexcept -> statistics const & { return m_statistics; }
+      auto inline reset_statistics /**/ () noexcept -> void { m_statistics = {}; }
+
+    private:
+#if /* */ defined(__EMSCRIPTEN__)
+      mode /*    */ m_mode       = mode::vsync; /* the browser paces frames with requestAnimationFrame */
+#else  // defined(__EMSCRIPTEN__)
+      mode /*    */ m_mode       = mode::sleep_spin;
+#endif // defined(__EMSCRIPTEN__)
+      duration /**/ m_margin     = std::chrono::milliseconds{1};
+      statistics    m_statistics = {};
+  };
+} // namespace engine
+
+#endif // ENGINE_FRAME_PACER_HPP
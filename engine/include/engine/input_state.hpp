@@ -0,0 +1,37 @@
+#ifndef ENGINE_INPUT_STATE_HPP
+#define ENGINE_INPUT_STATE_HPP
+
+#include <engine/core.hpp>
+
+#include <GLFW/glfw3.h>
+
+namespace engine
+{
+  /* Window and input state as of the last polled glfw callbacks, for layers that poll rather than handle events. */
+  struct input_state
+  {
+    public:
+      std::bitset<GLFW_KEY_LAST + 1> /*         */ keys             = {}; /* held down, by glfw key */
+      std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> /**/ mouse_buttons    = {}; /* held down, by glfw mouse button */
+      int /*                                  */ mods             = 0;  /* of the last key or mouse button event */
+      glm::dvec2 /*                           */ cursor_window    = {}; /* screen coordinates from the top left of the window */
+      glm::vec2 /*                            */ cursor_viewport  = {}; /* [-1, 1] over the viewport, y up */
+      bool /*                                 */ cursor_inside    = false,
+                                                   focused          = false;
+      glm::ivec2 /*                           */ window_size      = {},  /* screen coordinates */
+                                                   framebuffer_size = {}; /* pixels */
+      glm::vec2 /*                            */ content_scale    = {1.0f, 1.0f};
+      glm::ivec4 /*                           */ viewport         = {}; /* x, y, width, height in screen coordinates */
+
+      auto inline is_key_down /*         */ (int key) const noexcept -> bool { return 0 <= key and key <= GLFW_KEY_LAST and keys.test(static_cast<size_t>(key)); }
+      auto inline is_mouse_button_down /**/ (int button) const noexcept -> bool { return 0 <= button and button <= GLFW_MOUSE_BUTTON_LAST and mouse_buttons.test(static_cast<size_t>(button)); }
+      auto inline to_viewport(glm::dvec2 window_position) const noexcept -> glm::vec2
+      {
+        if (viewport.z <= 0 or viewport.w <= 0) return {};
+        return glm::vec2{/* */ (window_position.x - viewport.x) / viewport.z * 2.0 - 1.0,
+                         1.0 - (window_position.y - viewport.y) / viewport.w * 2.0 /* */};
+      }
+  };
+} // namespace engine
+
+#endif // ENGINE_INPUT_STATE_HPP
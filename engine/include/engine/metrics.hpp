@@ -0,0 +1,100 @@
+#ifndef ENGINE_METRICS_HPP
+#define ENGINE_METRICS_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+namespace engine::utilities
+{
+  /* Named counters, gauges and latency histograms. Lookups lock, recording through the returned references does not. */
+  struct metrics
+  {
+    public:
+      using clock    = std::chrono::steady_clock;
+      using duration = std::chrono::duration<double>;
+
+      struct counter
+      {
+        public:
+          auto inline add(uint64_t value = 1u) noexcept -> void { m_value.fetch_add(value, std::memory_order_relaxed); }
+          auto inline get() const noexcept -> uint64_t { return m_value.load(std::memory_order_relaxed); }
+
+        private:
+          std::atomic<uint64_t> m_value = 0u;
+      };
+      struct gauge
+      {
+        public:
+          auto inline set(double value) noexcept -> void { m_value.store(value, std::memory_order_relaxed); }
+          auto inline get() const noexcept -> double { return m_value.load(std::memory_order_relaxed); }
+
+        private:
+          std::atomic<double> m_value = 0.0;
+      };
+      /* log-linear buckets of nanoseconds, 16 linear sub-buckets per power of two keep the relative error under 6.25% */
+      struct histogram
+      {
+        public:
+          auto inline static constexpr s_sub_bucket_bits = 4u;
+          auto inline static constexpr s_sub_buckets     = 1zu << s_sub_bucket_bits;
+          auto inline static constexpr s_max_exponent    = 40u; /* about 18 minutes, longer samples land in the last bucket */
+          auto inline static constexpr s_bucket_count    = s_sub_buckets + (s_max_exponent - s_sub_bucket_bits) * s_sub_buckets;
+          auto inline static constexpr s_slice_count     = 8zu; /* the window is the last `s_slice_count - 1` whole slices and the current one */
+          auto inline static constexpr s_slice_period    = std::chrono::seconds{1};
+          struct snapshot
+          {
+              uint64_t count = 0u;
+              duration p50 = {}, p90 = {}, p99 = {}, max = {};
+          };
+
+          auto /*  */ record(duration value) noexcept -> void;
+          auto /*  */ get_snapshot() const noexcept -> snapshot;
+
+          auto static constexpr bucket_of(uint64_t nanoseconds) noexcept -> size_t
+          {
+            if (nanoseconds < s_sub_buckets) return static_cast<size_t>(nanoseconds);
+            auto const exponent = static_cast<uint32_t>(std::bit_width(nanoseconds)) - 1u;
+            if (exponent >= s_max_exponent) return s_bucket_count - 1zu;
+            auto const shift = exponent - s_sub_bucket_bits;
+            return s_sub_buckets + shift * s_sub_buckets + static_cast<size_t>((nanoseconds >> shift) - s_sub_buckets);
+          }
+          auto static constexpr bucket_upper_bound(size_t bucket) noexcept -> uint64_t /* inclusive, in nanoseconds */
+          {
+            if (bucket < s_sub_buckets) return bucket;
+            auto const shift = static_cast<uint32_t>((bucket - s_sub_buckets) / s_sub_buckets);
+            auto const sub   = static_cast<uint64_t>((bucket - s_sub_buckets) % s_sub_buckets);
+            return ((s_sub_buckets + sub + 1u) << shift) - 1u;
+          }
+
+        private:
+          struct slice
+          {
+              std::atomic<int64_t> /*                         */ epoch  = -1; /* index of the slice period it holds */
+              std::atomic<uint64_t> /*                        */ max    = 0u;
+              std::array<std::atomic<uint32_t>, s_bucket_count> counts = {};
+          };
+          std::array<slice, s_slice_count> m_slices = {};
+      };
+      struct report
+      {
+          std::vector<std::pair<std::string, uint64_t>> /*            */ counters   = {};
+          std::vector<std::pair<std::string, double>> /*              */ gauges     = {};
+          std::vector<std::pair<std::string, histogram::snapshot>> /* */ histograms = {};
+      };
+
+      auto /*  */ get_counter /*   */ (std::string_view name) -> counter &;
+      auto /*  */ get_gauge /*     */ (std::string_view name) -> gauge &;
+      auto /*  */ get_histogram /* */ (std::string_view name) -> histogram &;
+      auto /*  */ get_report() const -> report; /* sorted by name */
+
+    private:
+      template <typename T>
+      using named_t = std::map<std::string, std::unique_ptr<T>, std::less<>>; /* nodes keep references stable */
+      std::mutex mutable m_mutex      = {};
+      named_t<counter>   m_counters   = {};
+      named_t<gauge>     m_gauges     = {};
+      named_t<histogram> m_histograms = {};
+  };
+} // namespace engine::utilities
+
+#endif // ENGINE_METRICS_HPP
@@ -0,0 +1,83 @@
+#ifndef ENGINE_MPSC_QUEUE_HPP
+#define ENGINE_MPSC_QUEUE_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+namespace engine::utilities
+{
+  /* Bounded lock-free queue after Vyukov, any thread pushes, one thread pops. Pushing to a full queue fails instead of blocking. */
+  template <typename T>
+  struct mpsc_queue
+  {
+    public:
+      auto inline static constexpr s_cache_line = 64zu;
+
+      /**/ inline explicit mpsc_queue(size_t capacity)
+          : m_cells{std::make_unique<cell[]>(runtime_assert(std::has_single_bit(capacity) ? capacity : 0zu, "{} capacity {} is not a power of two", "mpsc queue", capacity))},
+            m_mask{capacity - 1zu}
+      {
+        for (auto const i : std::views::iota(0zu, capacity)) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+      /**/ inline mpsc_queue(mpsc_queue const &)           = delete; /* producers may hold on to it */
+      auto inline operator=(mpsc_queue const &) -> mpsc_queue & = delete;
+      /**/ inline ~mpsc_queue()
+      {
+        while (try_pop()) {}
+      }
+
+      template <typename... Args>
+        requires(std::constructible_from<T, Args...>)
+      auto inline try_push(Args &&...args) -> bool /* any thread */
+      {
+        auto position = m_push_position.load(std::memory_order_relaxed);
+        auto *target  = static_cast<cell *>(nullptr);
+        while (true)
+        {
+          target               = &m_cells[position & m_mask];
+          auto const sequence  = target->sequence.load(std::memory_order_acquire);
+          auto const lag       = static_cast<std::ptrdiff_t>(sequence - position);
+          if /**/ (lag == 0 and m_push_position.compare_exchange_weak(position, position + 1zu, std::memory_order_relaxed)) break;
+          else if (lag < 0) return m_dropped.fetch_add(1u, std::memory_order_relaxed), false; /* a lap behind, the queue is full */
+          else if (lag > 0) position = m_push_position.load(std::memory_order_relaxed);
+        }
+        std::construct_at(reinterpret_cast<T *>(target->storage), std::forward<Args>(args)...);
+        target->sequence.store(position + 1zu, std::memory_order_release);
+        return true;
+      }
+      auto inline try_pop() -> std::optional<T> /* the consumer thread only */
+      {
+        auto const position = m_pop_position.load(std::memory_order_relaxed);
+        auto      &source   = m_cells[position & m_mask];
+        if (source.sequence.load(std::memory_order_acquire) != position + 1zu) return std::nullopt; /* empty, or the push is still writing */
+        auto result = std::optional<T>{std::move(*source.get())};
+        std::destroy_at(source.get());
+        source.sequence.store(position + m_mask + 1zu, std::memory_order_release);
+        m_pop_position.store(position + 1zu, std::memory_order_relaxed);
+        return result;
+      }
+
+      auto inline get_capacity /* */ () const noexcept -> size_t { return m_mask + 1zu; }
+      auto inline get_depth /*    */ () const noexcept -> size_t /* approximate while pushes are in flight */
+      {
+        auto const popped = m_pop_position.load(std::memory_order_relaxed); /* first, pushes only ever run ahead of it */
+        return m_push_position.load(std::memory_order_relaxed) - popped;
+      }
+      auto inline get_dropped /*  */ () const noexcept -> uint64_t { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+      struct cell
+      {
+          std::atomic<size_t> sequence = 0zu;
+          alignas(T) std::byte storage[sizeof(T)];
+          auto inline get() noexcept -> T * { return std::launder(reinterpret_cast<T *>(storage)); } /* once pushed */
+      };
+      std::unique_ptr<cell[]> /*                */ m_cells         = {};
+      size_t /*                                  */ m_mask          = 0zu;
+      alignas(s_cache_line) std::atomic<size_t> /**/ m_push_position = 0zu; /* apart from the consumer's position, producers contend on it */
+      alignas(s_cache_line) std::atomic<size_t> /**/ m_pop_position  = 0zu;
+      std::atomic<uint64_t> /*                   */ m_dropped       = 0u;
+  };
+} // namespace engine::utilities
+
+#endif // ENGINE_MPSC_QUEUE_HPP
@@ -0,0 +1,52 @@
+#ifndef ENGINE_PROFILER_HPP
+#define ENGINE_PROFILER_HPP
+
+#include <engine/core.hpp>
+
+#if /* */ defined(ENGINE_PROFILE_SCOPE) or defined(ENGINE_PROFILE_CONCAT) or defined(ENGINE_PROFILE_CONCAT_IMPL)
+#error "Macro name collision"
+#endif // defined(ENGINE_PROFILE_SCOPE) or defined(ENGINE_PROFILE_CONCAT) or defined(ENGINE_PROFILE_CONCAT_IMPL)
+
+namespace engine::profiler
+{
+  using clock = std::chrono::steady_clock;
+  enum class track : uint8_t
+  {
+    cpu, /* the recording thread */
+    gpu, /* a single shared gpu timeline */
+  };
+  struct zone
+  {
+      char const /*  */ *name   = nullptr, /* both must outlive the trace export, e.g. literals or `typeid` names */
+                        *detail = nullptr;
+      clock::time_point begin   = {},
+                        end     = {};
+      track /*       */ where   = track::cpu;
+  };
+#if /* */ defined(ENGINE_PROFILER)
+  auto inline constexpr enabled = true;
+  auto /*  */ record(zone const &value) noexcept -> void; /* appends to a thread local ring, oldest zones are overwritten */
+  auto /*  */ write_chrome_trace(std::filesystem::path const &path) -> bool;
+  struct scope
+  {
+    public:
+      /**/ inline scope(char const *name, char const *detail = nullptr) noexcept : m_zone{.name = name, .detail = detail, .begin = clock::now()} {}
+      /**/ inline ~scope() noexcept { m_zone.end = clock::now(), record(m_zone); }
+      /**/ inline scope(scope const &) = delete;
+      auto inline operator=(scope const &) -> scope & = delete;
+
+    private:
+      zone m_zone;
+  };
+#define ENGINE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_IMPL(a, b)
+#define ENGINE_PROFILE_SCOPE(...) ::engine::profiler::scope const ENGINE_PROFILE_CONCAT(engine_profile_scope_, __LINE__){__VA_ARGS__}
+#else  // defined(ENGINE_PROFILER)
+  auto inline constexpr enabled = false;
+  auto inline record(zone const &value) noexcept -> void { (void)value; }
+  auto inline write_chrome_trace(std::filesystem::path const &path) -> bool { return (void)path, false; }
+#define ENGINE_PROFILE_SCOPE(...) static_cast<void>(0)
+#endif // defined(ENGINE_PROFILER)
+} // namespace engine::profiler
+
+#endif // ENGINE_PROFILER_HPP
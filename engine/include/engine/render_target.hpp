@@ -0,0 +1,71 @@
+#ifndef ENGINE_RENDER_TARGET_HPP
+#define ENGINE_RENDER_TARGET_HPP
+
+#include <engine/core.hpp>
+#include <engine/renderer.hpp>
+
+namespace engine
+{
+  enum class viewport_fit : uint8_t
+  {
+    cover,   /* square over the longer side, centered, the shorter side is cropped */
+    contain, /* square over the shorter side, centered, letterboxed */
+    stretch, /* the whole framebuffer, layers see a non-uniform scale */
+  };
+
+  /* Where layers render to: the default framebuffer, or an offscreen one scaled down from the viewport while the gpu runs over budget. */
+  struct render_target
+  {
+    public:
+      using duration = std::chrono::duration<double>;
+      auto inline static constexpr s_scale_step    = 1.0 / 16.0; /* scales are quantized so the target is not reallocated every frame */
+      auto inline static constexpr s_budget_share  = 0.8;        /* of the render period the gpu may take before the scale drops */
+      auto inline static constexpr s_raise_share   = 0.6;        /* of the budget under which the scale climbs back */
+      auto inline static constexpr s_default_scale = 0.5;        /* lowest scale unless configured otherwise */
+
+      /**/ inline render_target() noexcept {}
+      /**/ inline render_target(render_target /* */ &&o) noexcept
+      {
+        m_framebuffer = std::exchange(o.m_framebuffer /* */, {});
+        m_color       = std::exchange(o.m_color /*       */, {});
+        m_size        = std::exchange(o.m_size /*        */, {});
+        m_viewport    = std::exchange(o.m_viewport /*    */, {});
+        m_destination = std::exchange(o.m_destination /* */, {});
+        m_fit         = std::exchange(o.m_fit /*         */, {});
+        m_scale       = std::exchange(o.m_scale /*       */, 1.0);
+        m_min_scale   = std::exchange(o.m_min_scale /*   */, s_default_scale);
+        m_offscreen   = std::exchange(o.m_offscreen /*   */, {});
+      }
+      /**/ inline render_target(render_target const &&o) noexcept = delete;
+      auto inline operator=(render_target /* */ &&o) noexcept -> render_target & { return this->~render_target(), *new (this) render_target{std::move(o)}; }
+      auto inline operator=(render_target const &o) -> render_target & = delete;
+
+      auto static fit(viewport_fit mode, glm::ivec2 size) noexcept -> glm::ivec4; /* x, y, width, height within `size` */
+      auto /*  */ update_scale(std::span<renderer::gpu_timer::sample const> samples, duration render_period) -> void;
+      auto /*  */ begin(renderer &renderer, glm::ivec2 framebuffer_size) -> void; /* binds the target as the default framebuffer */
+      auto /*  */ end(renderer &renderer) -> void;                                 /* upscales into the viewport, after submit */
+      auto /*  */ reset() -> void;                                                  /* frees the offscreen target */
+
+      auto inline set_fit /*        */ (viewport_fit value) noexcept -> void { m_fit = value; }
+      auto inline get_fit /*        */ () const noexcept -> viewport_fit { return m_fit; }
+      auto inline set_min_scale /*  */ (double value) noexcept -> void { m_min_scale = std::clamp(value, s_scale_step, 1.0), m_scale = std::max(m_scale, m_min_scale); }
+      auto inline get_min_scale /*  */ () const noexcept -> double { return m_min_scale; }
+      auto inline get_scale /*      */ () const noexcept -> double { return m_scale; }
+      auto inline is_dynamic /*     */ () const noexcept -> bool { return m_min_scale < 1.0; }
+      auto inline get_viewport /*   */ () const noexcept -> glm::ivec4 { return m_viewport; }
+
+    private:
+      renderer::handle_cache::unique_handle
+          /*      */ m_framebuffer = {},
+                     m_color       = {};
+      glm::ivec2 /**/ m_size        = {}; /* of the offscreen target */
+      glm::ivec4 /**/ m_viewport    = {}; /* in the destination framebuffer */
+      uint32_t /*  */ m_destination = 0u;
+      viewport_fit    m_fit         = viewport_fit::cover;
+      double /*    */ m_scale       = 1.0,
+                      m_min_scale   = s_default_scale;
+      bool /*      */ m_offscreen   = false; /* of the frame in progress */
+  };
+} // namespace engine
+
+#endif // ENGINE_RENDER_TARGET_HPP
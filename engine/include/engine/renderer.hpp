@@ -35,15 +35,52 @@ namespace engine::utilities::gl
       default /*                               */: return "UNKNOWN" /*                       */;
     }
   }
+  enum class check_level : uint8_t
+  {
+    off,       /* `glCheckError` does nothing */
+    per_frame, /* `glCheckError` leaves a breadcrumb, `check_frame` reports errors once per frame */
+    per_call,  /* `glCheckError` reports errors at the call site */
+  };
+#if /* */ defined(ENGINE_GL_CHECK_LEVEL)
+  auto inline constexpr compiled_check_level = check_level{ENGINE_GL_CHECK_LEVEL}; /* the highest level `set_check_level` accepts */
+#else  // defined(ENGINE_GL_CHECK_LEVEL)
+  auto inline constexpr compiled_check_level = check_level::per_call;
+#endif // defined(ENGINE_GL_CHECK_LEVEL)
+  struct check_state
+  {
+      auto inline static constexpr s_breadcrumb_count = 8zu;
+#if /* */ defined(NDEBUG)
+      check_level /*                                     */ level        = check_level::off;
+#else  // defined(NDEBUG)
+      check_level /*                                     */ level        = compiled_check_level;
+#endif // defined(NDEBUG)
+      bool /*                                            */ debug_output = false; /* KHR_debug reports errors, `glGetError` is never called */
+      std::array<std::source_location, s_breadcrumb_count> breadcrumbs  = {};    /* recent `glCheckError` sites */
+      size_t /*                                          */ next         = 0zu;
+      std::mutex /*                                      */ mutex        = {};    /* debug output may be called back from a driver thread */
+      std::vector<std::string> /*                        */ reported     = {};    /* debug output errors not yet thrown, under `mutex` */
+  };
+  auto inline constinit s_check_state = check_state{};
+
+  /* at most `compiled_check_level`, returns the level in effect. `get_proc_address` loads KHR_debug where it is exposed, e.g. `glfwGetProcAddress` */
+  auto /*  */ set_check_level(check_level level, void (*(*get_proc_address)(char const *name))() = nullptr) -> check_level;
+  auto inline get_check_level() noexcept -> check_level { return s_check_state.level; }
+  auto /*  */ report_errors(std::source_location source_location) -> void; /* throws the oldest pending error */
+  auto inline check_frame(std::source_location source_location = std::source_location::current()) -> void
+  {
+    if constexpr (compiled_check_level != check_level::off)
+      if (s_check_state.level != check_level::off) report_errors(source_location);
+  }
   auto inline /*     */ check_error(std::source_location source_location = std::source_location::current()) -> void
   {
-    while (auto const e = glGetError() - GL_NO_ERROR)
-      runtime_assert<error>(false, "OpenGL Error: \"{}\" from {}:{}:{} in function {}", //
-                            error_to_string(e + GL_NO_ERROR),
-                            source_location.file_name(),
-                            source_location.line(),
-                            source_location.column(),
-                            source_location.function_name());
+    if constexpr (compiled_check_level != check_level::off)
+    {
+      auto &state = s_check_state;
+      if (state.level == check_level::off) return;
+      state.breadcrumbs[state.next++ % check_state::s_breadcrumb_count] = source_location;
+      if (state.level == check_level::per_call) report_errors(source_location);
+    }
+    else (void)source_location;
   }
 } // namespace engine::utilities::gl
 namespace engine
@@ -51,7 +88,7 @@ namespace engine
   struct renderer
   {
     public:
-      /* TODO: Consider refactor for `[...active, ...inactive, ...deactivated]` to avoid reuse.  */
+      /* Pool of gl object names. Slots are generation checked, freed names are reused warmest first. */
       struct handle_cache
       {
         public:
@@ -60,6 +97,8 @@ namespace engine
           {
               auto (*create_handles)(std::span<uint32_t> target) noexcept -> void = 0;
               auto (*delete_handles)(std::span<uint32_t> target) noexcept -> void = 0;
+              size_t retained                                                     = 16zu; /* warm inactive names kept by `trim` */
+              bool   recycle                                                      = true; /* false deletes names on release, for objects whose state outlives a user */
           };
           struct allocators
           {
@@ -68,45 +107,629 @@ namespace engine
               auto inline static constexpr framebuffers /*  */ = allocator{.create_handles = LAMBDA(glGenFramebuffers /*  */), .delete_handles = LAMBDA(glDeleteFramebuffers /*  */)};
               auto inline static constexpr renderbuffers /* */ = allocator{.create_handles = LAMBDA(glGenRenderbuffers /* */), .delete_handles = LAMBDA(glDeleteRenderbuffers /* */)};
               auto inline static constexpr textures /*      */ = allocator{.create_handles = LAMBDA(glGenTextures /*      */), .delete_handles = LAMBDA(glDeleteTextures /*      */)};
-              auto inline static constexpr vertexarrays /*  */ = allocator{.create_handles = LAMBDA(glGenVertexArrays /*  */), .delete_handles = LAMBDA(glDeleteVertexArrays /*  */)};
+              auto inline static constexpr vertexarrays /*  */ = allocator{.create_handles = LAMBDA(glGenVertexArrays /*  */), .delete_handles = LAMBDA(glDeleteVertexArrays /*  */), .recycle = false}; /* enabled attributes would leak into the next user */
 #undef LAMBDA
           };
+          struct handle
+          {
+              uint32_t name       = 0u,
+                       slot       = 0u,
+                       generation = 0u;
+              auto inline constexpr operator==(handle const &o) const noexcept -> bool = default;
+          };
+          struct statistics
+          {
+              size_t activations   = 0zu,
+                     deactivations = 0zu,
+                     creations     = 0zu,
+                     deletions     = 0zu;
+          };
+          struct unique_handle
+          {
+            public:
+              /**/ inline unique_handle() noexcept = default;
+              /**/ inline unique_handle(handle_cache &cache) : m_cache{&cache}, m_handle{cache.acquire()} {}
+              /**/ inline unique_handle(unique_handle /* */ &&o) noexcept : m_cache{std::exchange(o.m_cache, {})}, m_handle{std::exchange(o.m_handle, {})} {}
+              /**/ inline unique_handle(unique_handle const &o) noexcept = delete;
+              auto inline operator=(unique_handle /* */ &&o) noexcept -> unique_handle & { return this->~unique_handle(), *new (this) unique_handle{std::move(o)}; }
+              auto inline operator=(unique_handle const &o) -> unique_handle & = delete;
+              /**/ inline ~unique_handle() { reset(); }
 
-          /**/ inline handle_cache() noexcept = default;
+              auto inline get /*    */ () const noexcept -> uint32_t { return m_handle.name; }
+              auto inline get_handle () const noexcept -> handle { return m_handle; }
+              auto inline reset /*  */ () -> void { if (m_cache) std::exchange(m_cache, nullptr)->release(std::exchange(m_handle, {})); }
+              explicit inline operator bool() const noexcept { return m_cache != nullptr; }
+
+            private:
+              handle_cache *m_cache  = nullptr;
+              handle /*  */ m_handle = {};
+          };
+
+          /**/ inline handle_cache() noexcept {}
           /**/ inline handle_cache(allocator const *allocator) noexcept : m_allocator{allocator} {}
           /**/ inline handle_cache(handle_cache /* */ &&o) noexcept
           {
-            m_allocator = std::exchange(o.m_allocator /* */, {});
-            m_handles   = std::exchange(o.m_handles /*   */, {});
-            m_size      = std::exchange(o.m_size /*      */, {});
-            m_capacity  = std::exchange(o.m_capacity /*  */, {});
+            m_allocator  = std::exchange(o.m_allocator /*  */, {});
+            m_slots      = std::exchange(o.m_slots /*      */, {});
+            m_free       = std::exchange(o.m_free /*       */, {});
+            m_unnamed    = std::exchange(o.m_unnamed /*    */, {});
+            m_slot_of    = std::exchange(o.m_slot_of /*    */, {});
+            m_active     = std::exchange(o.m_active /*     */, {});
+            m_statistics = std::exchange(o.m_statistics /* */, {});
           }
           /**/ inline handle_cache(handle_cache const &&o) noexcept = delete;
           auto inline operator=(handle_cache /* */ &&o) -> handle_cache & { return this->~handle_cache(), *new (this) handle_cache{std::move(o)}; }
           auto inline operator=(handle_cache const &o) -> handle_cache & = delete;
-          /**/ inline ~handle_cache() { set_capacity(0); }
+          /**/ /*  */ ~handle_cache();
 
-          auto /*  */ set_capacity(size_t capacity) -> void;
           auto /*  */ reserve(size_t capacity) -> void;
+          auto /*  */ trim(size_t retained) -> void;
+          auto inline trim() -> void { return trim(runtime_assert(m_allocator, "null {} access", "allocator")->retained); }
+
+          auto /*  */ acquire() -> handle;
+          auto /*  */ release(handle value) -> void;
+          auto /*  */ is_valid(handle value) const noexcept -> bool;
+          auto inline make_unique() -> unique_handle { return unique_handle{*this}; }
+
+          auto inline activate() -> uint32_t { return acquire().name; }
+          auto /*  */ deactivate(uint32_t name) -> void;
+
+          auto inline get_allocator /*  */ () const noexcept { return m_allocator; }
+          auto inline get_statistics /* */ () const noexcept -> statistics const & { return m_statistics; }
+          auto inline active_count /*   */ () const noexcept -> size_t { return m_active; }
+          auto inline inactive_count /* */ () const noexcept -> size_t { return m_free.size(); }
+          auto inline capacity /*       */ () const noexcept -> size_t { return m_active + m_free.size(); }
+          auto inline occupancy /*      */ () const noexcept -> double { return capacity() ? static_cast<double>(m_active) / static_cast<double>(capacity()) : 0.0; }
+
+        private:
+          struct slot
+          {
+              uint32_t name       = 0u,
+                       generation = 0u;
+              bool     active     = false;
+          };
+          using slot_index_t = uint32_t;
+          allocator const /*                            */ *m_allocator = 0;
+          std::vector<slot> /*                           */ m_slots      = {};
+          std::vector<slot_index_t> /* coldest first     */ m_free       = {};
+          std::vector<slot_index_t> /* without a name    */ m_unnamed    = {};
+          std::unordered_map<uint32_t, slot_index_t> /*  */ m_slot_of    = {};
+          size_t /*                                      */ m_active     = 0zu;
+          statistics /*                                  */ m_statistics = {};
+      };
+      /* Shadows the bound GL state so redundant binds and uniform uploads are skipped. */
+      struct state_cache
+      {
+        public:
+          using uniform_value_t = std::variant<GLint, GLuint, GLfloat,
+                                               glm::ivec2, glm::ivec3, glm::ivec4,
+                                               glm::uvec2, glm::uvec3, glm::uvec4,
+                                               glm::vec2, glm::vec3, glm::vec4,
+                                               glm::mat2, glm::mat3, glm::mat4>;
+          struct counters
+          {
+              size_t issued  = 0zu,
+                     skipped = 0zu;
+          };
+          auto inline static constexpr s_unknown            = std::numeric_limits<uint32_t>::max();
+          auto inline static constexpr s_texture_unit_count = 16zu;
+          auto inline static constexpr s_buffer_targets     = std::array<GLenum, 7>{GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER};
+          auto inline static constexpr s_texture_targets    = std::array<GLenum, 4>{GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP};
+
+          /**/ inline state_cache() noexcept { invalidate(); }
+
+          auto /*  */ use_program /*       */ (uint32_t program) -> void;
+          auto /*  */ bind_vertex_array /* */ (uint32_t vertex_array) -> void;
+          auto /*  */ bind_buffer /*       */ (GLenum target, uint32_t buffer) -> void;
+          auto /*  */ bind_framebuffer /*  */ (GLenum target, uint32_t framebuffer) -> void;
+          auto /*  */ bind_texture /*      */ (uint32_t unit, GLenum target, uint32_t texture) -> void;
+          auto /*  */ uniform /*           */ (int32_t location, uniform_value_t const &value) -> void;
+
+          auto /*  */ forget_program(uint32_t program) -> void;
+          auto /*  */ invalidate() noexcept -> void;
+          auto /*  */ begin_frame() noexcept -> void;
+
+          auto inline get_program /*        */ () const noexcept { return m_program; }
+          /* framebuffer 0 binds resolve to this one, e.g. the offscreen target of headless runs */
+          auto inline set_default_framebuffer /* */ (uint32_t framebuffer) noexcept -> void { m_default_framebuffer = framebuffer; }
+          auto inline get_default_framebuffer /* */ () const noexcept -> uint32_t { return m_default_framebuffer; }
+          auto inline get_frame_counters /* */ () const noexcept -> counters const & { return m_last_frame; }
+          auto inline get_total_counters /* */ () const noexcept -> counters const & { return m_total; }
+
+        private:
+          using buffer_bindings_t  = std::array<uint32_t, s_buffer_targets.size()>;
+          using texture_bindings_t = std::array<std::array<uint32_t, s_texture_targets.size()>, s_texture_unit_count>;
+          using uniform_values_t   = std::unordered_map<uint64_t /* program << 32 | location */, uniform_value_t>;
+          auto inline issue /* */ () noexcept -> void { m_frame.issued++, m_total.issued++; }
+          auto inline skip /*  */ () noexcept -> void { m_frame.skipped++, m_total.skipped++; }
+          uint32_t /*     */ m_program             = s_unknown,
+                             m_vertex_array        = s_unknown,
+                             m_draw_framebuffer    = s_unknown,
+                             m_read_framebuffer    = s_unknown,
+                             m_active_texture      = s_unknown,
+                             m_default_framebuffer = 0u;
+          buffer_bindings_t  m_buffers             = {};
+          texture_bindings_t m_textures            = {};
+          uniform_values_t   m_uniforms            = {};
+          counters /*     */ m_frame               = {},
+                             m_last_frame          = {},
+                             m_total               = {};
+      };
+      state_cache state = {};
+
+      /* Draw packets recorded by layers into a per-frame arena, sorted by state key and submitted in one pass. */
+      struct command_list
+      {
+        public:
+          auto inline static constexpr s_arena_inline_size = 0x01'00'00zu;
+          struct texture_binding
+          {
+              uint32_t unit    = 0u;
+              GLenum   target  = GL_TEXTURE_2D;
+              uint32_t texture = 0u;
+          };
+          struct uniform_binding
+          {
+              int32_t /*                  */ location = -1;
+              state_cache::uniform_value_t value    = {};
+          };
+          struct draw_arrays
+          {
+              GLenum  mode      = GL_TRIANGLES;
+              GLint   first     = 0;
+              GLsizei count     = 0;
+              GLsizei instances = 1;
+          };
+          struct draw_elements
+          {
+              GLenum    mode      = GL_TRIANGLES;
+              GLsizei   count     = 0;
+              GLenum    type      = GL_UNSIGNED_SHORT;
+              uintptr_t offset    = 0u;
+              GLsizei   instances = 1;
+          };
+          struct clear
+          {
+              GLbitfield mask  = GL_COLOR_BUFFER_BIT;
+              glm::vec4  color = {};
+          };
+          using command_t = std::variant<draw_arrays, draw_elements, clear>;
+          struct packet
+          {
+              uint32_t /*                    */ program      = 0u,
+                                                vertex_array = 0u;
+              std::span<texture_binding const> textures     = {};
+              std::span<uniform_binding const> uniforms     = {};
+              command_t /*                   */ command      = draw_arrays{};
+          };
+
+          /**/ inline command_list() : m_arena{std::make_unique<arena>()} {}
+          /**/ inline command_list(command_list /* */ &&o) noexcept = default;
+          /**/ inline command_list(command_list const &o) noexcept  = delete;
+          auto inline operator=(command_list /* */ &&o) noexcept -> command_list & { return this->~command_list(), *new (this) command_list{std::move(o)}; }
+          auto inline operator=(command_list const &o) -> command_list & = delete;
+          /**/ inline ~command_list() = default;
+
+          auto /*  */ record(packet const &packet) -> void;
+          auto /*  */ barrier() -> void;
+          auto /*  */ submit(state_cache &state) -> void;
+
+          auto inline get_frame_packet_count() const noexcept { return m_last_packet_count; }
+          auto inline get_frame_group_count /**/ () const noexcept { return m_last_group_count; }
+          auto inline get_arena /*            */ () noexcept -> std::pmr::memory_resource & { return m_arena->resource; }
+
+        private:
+          struct arena
+          {
+              alignas(std::max_align_t) std::array<std::byte, s_arena_inline_size> buffer = {};
+              std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+          };
+          struct sort_key /* full names, distinct objects never share a key */
+          {
+              uint32_t group        = 0u,
+                       program      = 0u,
+                       vertex_array = 0u,
+                       texture      = 0u;
+              auto inline constexpr operator<=>(sort_key const &o) const noexcept -> auto = default;
+          };
+          struct entry
+          {
+              sort_key key  = {};
+              packet   data = {};
+          };
+          auto /*  */ reset() -> void;
+          std::unique_ptr<arena>    m_arena             = {};
+          std::pmr::vector<entry>   m_entries           = std::pmr::vector<entry>{&m_arena->resource};
+          uint32_t /*            */ m_group             = 0u;
+          size_t /*              */ m_last_packet_count = 0zu,
+                                    m_last_group_count  = 0zu;
+      };
+      command_list commands = {};
+
+      /* Deduplicates linked programs by a hash of their sources and persists program binaries across runs.
+       * The in-process entries live as long as the renderer: an empty layer stack only trims pooled objects, so switching layers relinks nothing. */
+      struct program_cache
+      {
+        public:
+          auto inline static constexpr s_retained_unreferenced = 16zu;
+          auto inline static constexpr s_completion_status_khr = GLenum{0x91'B1}; /* KHR_parallel_shader_compile */
+          enum class program_status : uint8_t
+          {
+            pending,
+            ready,
+            failed,
+          };
+          struct statistics
+          {
+              size_t hits         = 0zu,
+                     compiles     = 0zu,
+                     disk_loads   = 0zu,
+                     disk_writes  = 0zu,
+                     disk_rejects = 0zu;
+          };
+
+          /**/ /*  */ program_cache() noexcept;                   /* out of line, `writer` is only complete in the source */
+          /**/ /*  */ program_cache(program_cache /* */ &&o) noexcept;
+          /**/ inline program_cache(program_cache const &&o) noexcept = delete;
+          auto inline operator=(program_cache /* */ &&o) -> program_cache & { return this->~program_cache(), *new (this) program_cache{std::move(o)}; }
+          auto inline operator=(program_cache const &o) -> program_cache & = delete;
+          /**/ /*  */ ~program_cache();
 
-          auto /*  */ activate() -> uint32_t;
-          auto /*  */ deactivate(uint32_t handle) -> void;
+          auto /*  */ acquire /*       */ (std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) -> uint32_t;
+          auto /*  */ acquire_async /* */ (std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) -> uint32_t;
+          auto /*  */ release(uint32_t program, state_cache &state) -> void;
+          auto /*  */ trim(state_cache &state) -> void;
+          auto /*  */ poll() -> void; /* once per frame, resolves pending programs without stalling, binaries are written in the background */
+          auto /*  */ get_status(uint32_t program) const -> program_status;
+          auto inline is_ready(uint32_t program) const -> bool { return get_status(program) == program_status::ready; }
 
-          auto inline get_allocator() const noexcept { return m_allocator; }
+          auto /*  */ set_directory(std::filesystem::path directory) -> void;
+          auto /*  */ get_directory() -> std::filesystem::path const &; /* the user cache directory unless set, empty when there is none */
+          auto inline set_persistence /* */ (bool value) noexcept -> void { m_persistence = value; }
+          auto inline get_statistics /*  */ () const noexcept -> statistics const & { return m_statistics; }
 
-          auto inline all /*      */ () const noexcept -> std::span<uint32_t const> { return std::span{m_handles.get(), m_capacity}; }
-          auto inline active /*   */ () const noexcept -> std::span<uint32_t const> { return all().subspan(0, m_size); }
-          auto inline inactive /* */ () const noexcept -> std::span<uint32_t const> { return all().subspan(m_size); }
+          auto static hash_sources(std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) noexcept -> uint64_t;
 
         private:
-          auto inline all /*      */ () /* */ noexcept -> std::span<uint32_t /* */> { return std::span{m_handles.get(), m_capacity}; }
-          auto inline active /*   */ () /* */ noexcept -> std::span<uint32_t /* */> { return all().subspan(0, m_size); }
-          auto inline inactive /* */ () /* */ noexcept -> std::span<uint32_t /* */> { return all().subspan(m_size); }
-          allocator const            *m_allocator = 0;
-          std::unique_ptr<uint32_t[]> m_handles   = 0;
-          uint32_t /*              */ m_size      = 0,
-                                      m_capacity  = 0;
+          struct entry
+          {
+              uint32_t /*          */ program    = 0u;
+              size_t /*            */ references = 0zu;
+              program_status /*    */ status     = program_status::pending;
+              std::array<uint32_t, 2> shaders    = {};
+              size_t /*            */ frame      = 0zu;
+              std::string /*       */ error      = {};
+          };
+          struct binary_header
+          {
+              std::array<char, 8> magic       = {'G', 'L', 'P', 'R', 'O', 'G', '0', '1'};
+              uint64_t /*      */ source_hash = 0u,
+                                  driver_hash = 0u;
+              uint32_t /*      */ format      = 0u,
+                                  length      = 0u;
+          };
+          auto /*  */ persistence_available() -> bool;
+          auto /*  */ driver_hash() -> uint64_t;
+          auto /*  */ binary_path(uint64_t key) -> std::filesystem::path;
+          auto /*  */ load_binary(uint32_t program, uint64_t key) -> bool;
+          auto /*  */ store_binary(uint32_t program, uint64_t key) -> void;
+          auto /*  */ evict(uint64_t key, state_cache &state) -> void;
+          auto /*  */ resolve(uint64_t key, entry &entry, bool wait) -> void;
+          auto /*  */ parallel_available() -> bool;
+          struct writer;
+          std::unordered_map<uint64_t /* source hash */, entry> m_entries      = {};
+          std::unordered_map<uint32_t /* program */, uint64_t>  m_keys         = {};
+          std::vector<uint64_t /* source hash, oldest first */>  m_unreferenced = {};
+          std::filesystem::path /*                           */ m_directory    = {};
+#if /* */ defined(__EMSCRIPTEN__)
+          std::optional<bool> /*                             */ m_persistence  = false; /* WebGL has no program binaries */
+#else  // defined(__EMSCRIPTEN__)
+          std::optional<bool> /*                             */ m_persistence  = {}; /* resolved on first use */
+#endif // defined(__EMSCRIPTEN__)
+          std::optional<uint64_t> /*                         */ m_driver_hash  = {};
+          std::optional<bool> /*                             */ m_parallel     = {};
+          size_t /*                                          */ m_frame        = 0zu;
+          std::unique_ptr<writer> /*                         */ m_writer       = {}; /* started by the first store */
+          statistics /*                                      */ m_statistics   = {};
+      };
+      program_cache programs = {};
+
+      /* EXT_disjoint_timer_query elapsed time of a bracketed span of gpu work, read back frames later without stalling. */
+      struct gpu_timer
+      {
+        public:
+          using clock    = std::chrono::steady_clock;
+          using duration = std::chrono::duration<double>;
+          auto inline static constexpr s_query_count      = 4zu;
+          auto inline static constexpr s_time_elapsed_ext = GLenum{0x88'BF};
+          auto inline static constexpr s_gpu_disjoint_ext = GLenum{0x8F'BB};
+          struct sample
+          {
+              clock::time_point begin   = {}; /* cpu time of `begin`, for lining the span up with cpu zones */
+              duration /*    */ elapsed = {};
+          };
+
+          /**/ inline gpu_timer() noexcept {}
+          /**/ inline gpu_timer(gpu_timer /* */ &&o) noexcept
+          {
+            m_queries   = std::exchange(o.m_queries /*   */, {});
+            m_begins    = std::exchange(o.m_begins /*    */, {});
+            m_pending   = std::exchange(o.m_pending /*   */, {});
+            m_next      = std::exchange(o.m_next /*      */, {});
+            m_active    = std::exchange(o.m_active /*    */, {});
+            m_supported = std::exchange(o.m_supported /* */, {});
+            m_last      = std::exchange(o.m_last /*      */, {});
+            m_completed = std::exchange(o.m_completed /* */, {});
+          }
+          /**/ inline gpu_timer(gpu_timer const &&o) noexcept = delete;
+          auto inline operator=(gpu_timer /* */ &&o) -> gpu_timer & { return this->~gpu_timer(), *new (this) gpu_timer{std::move(o)}; }
+          auto inline operator=(gpu_timer const &o) -> gpu_timer & = delete;
+          /**/ /*  */ ~gpu_timer();
+
+          auto /*  */ begin() -> void; /* skipped while every query is still in flight */
+          auto /*  */ end() -> void;
+          auto /*  */ poll() -> std::span<sample const>; /* completed samples, oldest first, valid until the next poll */
+          auto /*  */ is_supported() -> bool;
+          auto inline get_last() const noexcept -> std::optional<sample> { return m_last; }
+
+        private:
+          std::array<GLuint, s_query_count> /*      */ m_queries   = {};
+          std::array<clock::time_point, s_query_count> m_begins    = {};
+          std::array<bool, s_query_count> /*        */ m_pending   = {};
+          size_t /*                                 */ m_next      = 0zu;
+          bool /*                                   */ m_active    = false;
+          std::optional<bool> /*                    */ m_supported = {};
+          std::optional<sample> /*                  */ m_last      = {};
+          std::array<sample, s_query_count> /*      */ m_completed = {};
+      };
+      gpu_timer frame_timer = {};
+
+      /* Reads the default framebuffer back through a ring of pixel pack buffers and encodes it on a background thread, frames later. A y4m stream keeps its first frame size, a resize fails the encoder and the next `poll` stops the capture and rethrows. */
+      struct frame_capture
+      {
+        public:
+          enum class format : uint8_t
+          {
+            y4m, /* one file, 4:4:4 full range, 8 bit */
+            png, /* a directory of numbered rgba images */
+          };
+          auto inline static constexpr s_ring_size     = 4zu;  /* readbacks in flight before one has to be waited for */
+          auto inline static constexpr s_encoder_depth = 16zu; /* frames queued for the encoder before the render thread waits */
+          struct statistics
+          {
+              uint64_t captured       = 0u,
+                       encoded        = 0u,
+                       readback_waits = 0u, /* the ring was full of unsignaled fences */
+                       encoder_waits  = 0u, /* the encoder fell behind */
+                       dropped        = 0u; /* readbacks whose fence timed out or failed, never encoded */
+          };
+
+          /**/ /*  */ frame_capture() noexcept;                   /* out of line, `encoder` is only complete in the source */
+          /**/ /*  */ frame_capture(frame_capture /* */ &&o) noexcept;
+          /**/ inline frame_capture(frame_capture const &&o) noexcept = delete;
+          auto inline operator=(frame_capture /* */ &&o) -> frame_capture & { return this->~frame_capture(), *new (this) frame_capture{std::move(o)}; }
+          auto inline operator=(frame_capture const &o) -> frame_capture & = delete;
+          /**/ /*  */ ~frame_capture();
+
+          auto /*  */ start(std::filesystem::path path, format value, uint32_t frame_rate) -> void;
+          auto /*  */ read(renderer &owner, glm::ivec2 size) -> void; /* after the frame is drawn, before it is swapped */
+          auto /*  */ poll(state_cache &state) -> void;              /* hands finished readbacks to the encoder, never waits */
+          auto /*  */ stop(state_cache &state) -> void;              /* waits for every readback and the encoder */
+          auto /*  */ release() -> void;                             /* drops readbacks in flight and the pack buffers, before the handle caches go away */
+          auto /*  */ get_statistics() const noexcept -> statistics;
+          auto inline is_active() const noexcept -> bool { return m_encoder != nullptr; }
+
+        private:
+          struct slot
+          {
+              handle_cache::unique_handle buffer = {};
+              GLsync /*                */ fence  = {};
+              glm::ivec2 /*            */ size   = {};
+          };
+          struct encoder;
+          auto /*  */ settle(slot &slot, state_cache &state) -> void;  /* waits on a readback, collects it or counts it dropped */
+          auto /*  */ collect(slot &slot, state_cache &state) -> void; /* maps a signaled readback and queues it for encoding */
+
+          std::array<slot, s_ring_size> m_slots      = {};
+          size_t /*                  */ m_next       = 0zu;
+          size_t /*                  */ m_in_flight  = 0zu;
+          std::unique_ptr<encoder> /**/ m_encoder    = {};
+          statistics /*              */ m_statistics = {};
       };
+      frame_capture capture = {};
+
+      /* Instanced quads and triangles staged per layer, sorted by program and texture and streamed through a ring of per-frame buffer segments.
+       * Buffers, vertex arrays and the built in program come from the owning renderer's caches and are returned by `release`. */
+      struct sprite_batch
+      {
+        public:
+          enum class primitive : uint8_t
+          {
+            quad,     /* unit square centered on the position */
+            triangle, /* pointing along +x, the boids shape */
+          };
+          auto inline static constexpr s_ring_size        = 3zu;    /* frames the gpu may lag behind before a segment is waited for */
+          auto inline static constexpr s_initial_capacity = 1024zu; /* instances per segment, grown to fit the largest frame */
+          struct instance
+          {
+              glm::vec2 position = {};             /* clip space center */
+              glm::vec2 size     = {1.0f, 1.0f};   /* clip space extent of the unit primitive */
+              glm::vec4 color    = {1.0f, 1.0f, 1.0f, 1.0f};
+              glm::vec4 uv       = {0.0f, 0.0f, 1.0f, 1.0f}; /* texture offset in xy, scale in zw */
+              float     rotation = 0.0f;           /* radians, counter clockwise */
+          };
+          struct statistics
+          {
+              uint64_t instances   = 0u,
+                       draws       = 0u,
+                       flushes     = 0u,
+                       fence_waits = 0u, /* a segment was reused before the gpu finished reading it */
+                       growths     = 0u;
+          };
+          /* instance inputs and helpers for custom programs, pulled in with `#include "engine/sprite_batch.glsl"` through `shader_variants` */
+          auto inline static constexpr s_glsl_interface = std::string_view{R"glsl(
+            layout(location = 0) in vec2  sprite_position;
+            layout(location = 1) in vec2  sprite_size;
+            layout(location = 2) in vec4  sprite_color;
+            layout(location = 3) in vec4  sprite_uv;
+            layout(location = 4) in float sprite_rotation;
+            uniform int sprite_primitive;
+            vec2 sprite_triangle[3] = vec2[3](vec2(+0.5f, +0.0f), vec2(-0.5f, +0.5f), vec2(-0.5f, -0.5f));
+            vec2 sprite_corner()
+            {
+              if (sprite_primitive == 1) return sprite_triangle[gl_VertexID % 3];
+              return vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) - 0.5f;
+            }
+            vec2 sprite_texcoord()
+            {
+              return sprite_uv.xy + (sprite_corner() + 0.5f) * sprite_uv.zw;
+            }
+            vec4 sprite_clip_position()
+            {
+              float s = sin(sprite_rotation), c = cos(sprite_rotation);
+              return vec4(sprite_position + mat2(c, s, -s, c) * (sprite_corner() * sprite_size), 0.0f, 1.0f);
+            }
+          )glsl"};
+
+          /**/ inline sprite_batch() noexcept {}
+          /**/ inline sprite_batch(sprite_batch /* */ &&o) noexcept
+          {
+            m_staged        = std::exchange(o.m_staged /*        */, {});
+            m_upload        = std::exchange(o.m_upload /*        */, {});
+            m_locations     = std::exchange(o.m_locations /*     */, {});
+            m_vertex_arrays = std::exchange(o.m_vertex_arrays /* */, {});
+            m_retired       = std::exchange(o.m_retired /*       */, {});
+            m_fences        = std::exchange(o.m_fences /*        */, {});
+            m_buffer        = std::exchange(o.m_buffer /*        */, {});
+            m_program       = std::exchange(o.m_program /*       */, {});
+            m_capacity      = std::exchange(o.m_capacity /*      */, {});
+            m_segment       = std::exchange(o.m_segment /*       */, {});
+            m_used          = std::exchange(o.m_used /*          */, {});
+            m_runs          = std::exchange(o.m_runs /*          */, {});
+            m_statistics    = std::exchange(o.m_statistics /*    */, {});
+          }
+          /**/ inline sprite_batch(sprite_batch const &&o) noexcept = delete;
+          auto inline operator=(sprite_batch /* */ &&o) -> sprite_batch & { return this->~sprite_batch(), *new (this) sprite_batch{std::move(o)}; }
+          auto inline operator=(sprite_batch const &o) -> sprite_batch & = delete;
+          /**/ inline ~sprite_batch() = default; /* gl objects are returned by `release`, which the renderer calls */
+
+          /* `program` 0 is the built in one, others come from `programs` and include `engine/sprite_batch.glsl`. blending is left to the caller */
+          auto inline add(primitive shape, instance const &value, uint32_t texture = 0u, uint32_t program = 0u) -> void { m_staged.push_back({{program, texture, shape}, value}); }
+          auto /*  */ add(primitive shape, std::span<instance const> values, uint32_t texture = 0u, uint32_t program = 0u) -> void;
+          auto /*  */ flush(renderer &owner) -> void;     /* one packet per program, texture and primitive run */
+          auto inline discard() noexcept -> void { m_staged.clear(); } /* drops what was staged since the last flush, e.g. by a layer that threw */
+          auto /*  */ end_frame(renderer &owner) -> void; /* after the command list is submitted */
+          auto /*  */ release(renderer &owner) -> void;   /* hands every gl object back to `owner`, before its caches go away */
+          auto inline get_statistics() const noexcept -> statistics const & { return m_statistics; }
+
+        private:
+          struct run_key
+          {
+              uint32_t  program = 0u,
+                        texture = 0u;
+              primitive shape   = primitive::quad;
+              auto inline constexpr operator<=>(run_key const &o) const noexcept -> auto = default;
+          };
+          struct staged
+          {
+              run_key  key   = {};
+              instance value = {};
+          };
+          struct uniform_locations
+          {
+              uint32_t program  = 0u;
+              int32_t  shape    = -1,
+                       texture  = -1,
+                       textured = -1;
+          };
+          auto /*  */ reserve(renderer &owner, size_t count) -> void; /* room for `count` more instances in the current segment */
+          auto /*  */ locations(uint32_t program) -> uniform_locations const &;
+          auto /*  */ default_program(renderer &owner) -> uint32_t;
+
+          std::vector<staged> /*               */ m_staged        = {};
+          std::vector<instance> /*             */ m_upload        = {}; /* packed staged instances, webgl can not map buffers */
+          std::vector<uniform_locations> /*    */ m_locations     = {}; /* looked up once per frame, names of released programs are reused */
+          std::vector<handle_cache::handle> /* */ m_vertex_arrays = {}; /* one per run, attribute offsets point at the run */
+          std::vector<handle_cache::handle> /* */ m_retired       = {}; /* outgrown buffers still read by runs recorded this frame */
+          std::array<GLsync, s_ring_size> /*   */ m_fences        = {};
+          handle_cache::handle /*              */ m_buffer        = {};
+          uint32_t /*                          */ m_program       = 0u;
+          size_t /*                            */ m_capacity      = 0zu, /* instances per segment */
+                                                  m_segment       = 0zu,
+                                                  m_used          = 0zu, /* instances written to the current segment this frame */
+                                                  m_runs          = 0zu; /* vertex arrays pointed at this frame */
+          statistics /*                        */ m_statistics    = {};
+      };
+      sprite_batch sprites = {};
+
+      /* Specializes shader templates with injected `#define`s and resolved `#include`s, expanded once per define set and linked by the program cache. */
+      struct shader_variants
+      {
+        public:
+          struct define
+          {
+              std::string name  = {},
+                          value = {};
+              auto inline constexpr operator<=>(define const &o) const noexcept -> auto = default;
+          };
+          struct statistics
+          {
+              size_t hits       = 0zu,
+                     expansions = 0zu;
+          };
+          /* always resolvable, user includes of the same name take precedence */
+          auto inline static constexpr s_builtin_includes = std::array{
+              std::pair{std::string_view{"engine/sprite_batch.glsl"}, sprite_batch::s_glsl_interface},
+          };
+
+          /**/ inline shader_variants() noexcept {}
+          /**/ inline shader_variants(shader_variants /* */ &&o) noexcept = default;
+          /**/ inline shader_variants(shader_variants const &o) noexcept  = delete;
+          auto inline operator=(shader_variants /* */ &&o) noexcept -> shader_variants & { return this->~shader_variants(), *new (this) shader_variants{std::move(o)}; }
+          auto inline operator=(shader_variants const &o) -> shader_variants & = delete;
+          /**/ inline ~shader_variants() = default;
+
+          /* a `#define` whose value is `value` spelled as a glsl literal, e.g. `ivec2(128, 128)` or `3u` */
+          template <typename T>
+          auto inline static make_define(std::string name, T const &value) -> define { return {std::move(name), glsl_literal(value)}; }
+          template <typename T>
+          auto inline static glsl_literal(T const &value) -> std::string
+          {
+            /**/ if constexpr (std::same_as<T, bool>) return value ? "true" : "false";
+            else if constexpr (std::unsigned_integral<T>) return std::format("{}u", value);
+            else if constexpr (std::signed_integral<T>) return std::format("{}", value);
+            else if constexpr (std::floating_point<T>)
+            {
+              runtime_assert<std::invalid_argument>(std::isfinite(value), "{} has no glsl literal", value);
+              auto literal = std::format("{}", value);
+              return literal.find_first_of(".e") == std::string::npos ? literal + ".0" : literal;
+            }
+            else if constexpr (std::same_as<T, glm::vec<T::length(), typename T::value_type>>)
+            {
+              using component_t = typename T::value_type;
+              auto literal      = std::format("{}vec{}(", std::same_as<component_t, bool> ? "b" : std::unsigned_integral<component_t> ? "u" : std::signed_integral<component_t> ? "i" : "", T::length());
+              for (auto const i : std::views::iota(glm::length_t{0}, T::length())) literal += (i ? ", " : "") + glsl_literal(value[i]);
+              return literal + ")";
+            }
+            else static_assert(false, "no glsl literal for this type");
+          }
+
+          /* makes `#include "name"` resolve to `source`, each name is included once per stage */
+          auto /*  */ add_include(std::string name, std::string source) -> void;
+          /* like `program_cache::acquire_async`, released there as well. `defines` go right after the `#version` line */
+          auto /*  */ acquire(program_cache &programs, std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources, std::span<define const> defines) -> uint32_t;
+          auto /*  */ expand(std::span<std::string_view const> sources, std::span<define const> defines) const -> std::string; /* one stage's final source */
+          auto inline get_statistics() const noexcept -> statistics const & { return m_statistics; }
+
+        private:
+          auto /*  */ find_include(std::string_view name) const -> std::string_view;
+          auto /*  */ resolve(std::string_view source, std::string &target, std::vector<std::string_view> &included) const -> void;
+          std::unordered_map<std::string, std::string> /*                      */ m_includes     = {};
+          std::unordered_map<uint64_t /* sources and defines hash */, std::array<std::string, 2>> m_permutations = {}; /* expanded vertex and fragment sources */
+          statistics /*                                                        */ m_statistics   = {};
+      };
+      shader_variants shaders = {};
+
       handle_cache
           buffers       = {&handle_cache::allocators::buffers /*       */},
           framebuffers  = {&handle_cache::allocators::framebuffers /*  */},
@@ -116,16 +739,23 @@ namespace engine
 
     public:
       /**/ inline renderer() noexcept                                = default;
-      /**/ inline ~renderer() noexcept                               = default;
+      /**/ inline ~renderer() { capture.release(); sprites.release(*this); }
       /**/ inline renderer(renderer /**/ &&) noexcept                = default;
       /**/ inline renderer(renderer const &) noexcept                = delete;
-      auto inline operator=(renderer /**/ &&) noexcept -> renderer & = default;
+      auto inline operator=(renderer /**/ &&o) -> renderer & { return this->~renderer(), *new (this) renderer{std::move(o)}; }
       auto inline operator=(renderer const &) noexcept -> renderer & = delete;
 
     public:
+      auto /*  */ trim() -> void; /* drops cold pooled objects, keeps warm ones for the next layers */
       auto static compile_shader(uint32_t shader, std::span<std::string_view const> shader_sources) -> void;
       auto inline compile_shader(uint32_t shader, std::string_view shader_source) { return compile_shader(shader, std::span{&shader_source, 1}); }
       auto static link_program(uint32_t program, std::span<uint32_t const> shaders) -> void;
+      /* split halves of `compile_shader` and `link_program`, status checks block until the driver finishes */
+      auto static submit_shader /*  */ (uint32_t shader, std::span<std::string_view const> shader_sources) -> void;
+      auto static check_shader /*   */ (uint32_t shader) -> void;
+      auto static submit_program /* */ (uint32_t program, std::span<uint32_t const> shaders) -> void;
+      auto static check_program /*  */ (uint32_t program) -> void;
+      auto static has_extension /*  */ (std::string_view name) -> bool;
   };
 } // namespace engine
 
@@ -0,0 +1,100 @@
+#ifndef ENGINE_STATS_SINK_HPP
+#define ENGINE_STATS_SINK_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+#include <condition_variable>
+
+namespace engine::utilities
+{
+  /* Collects published statistics tables and renders them off the hot path at a low fixed rate. */
+  struct stats_sink
+  {
+    public:
+      using clock    = std::chrono::steady_clock;
+      using duration = std::chrono::duration<double>;
+      enum class format : uint8_t
+      {
+        none,
+        ansi_table, /* the `print_ansi_table` overlay on stdout */
+        csv,        /* long form under a single `time,table,column,value` header, one row per value */
+        jsonl,      /* one object per table and render */
+      };
+      enum class kind : uint8_t
+      {
+        signed_integer,
+        unsigned_integer,
+        floating_point,
+      };
+      struct entry
+      {
+          template <typename T>
+            requires(std::integral<T> or std::floating_point<T>)
+          /**/ inline constexpr entry(std::string_view name, T value) noexcept : name{name}
+          {
+            /**/ if constexpr (std::floating_point<T>) type = kind::floating_point /*   */, bits = std::bit_cast<uint64_t>(static_cast<double>(value));
+            else if constexpr (std::signed_integral<T>) type = kind::signed_integer /*   */, bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+            else /*                                  */ type = kind::unsigned_integer /* */, bits = static_cast<uint64_t>(value);
+          }
+          std::string_view name = {}; /* must outlive the sink, e.g. a literal */
+          kind /*       */ type = kind::unsigned_integer;
+          uint64_t /*   */ bits = 0u;
+      };
+
+    private:
+      struct table_state
+      {
+          std::string /*                         */ title          = {};
+          std::vector<std::string_view> /*        */ names          = {}; /* written once by the first publish, before `named` */
+          std::unique_ptr<std::atomic<uint64_t>[]> values         = {};
+          std::unique_ptr<std::atomic<kind>[]> /* */ kinds          = {};
+          std::atomic<bool> /*                   */ named          = false;
+          std::atomic<uint64_t> /*               */ sequence       = 0u; /* odd while a publish is in progress */
+      };
+
+    public:
+      /* single writer table, publishing is a handful of relaxed stores bracketed by a sequence counter */
+      struct table
+      {
+        public:
+          /**/ inline table() noexcept = default;
+          auto /*  */ publish(std::initializer_list<entry> entries) noexcept -> void;
+
+        private:
+          friend stats_sink;
+          /**/ inline table(std::shared_ptr<table_state> state) noexcept : m_state{std::move(state)} {}
+          std::shared_ptr<table_state> m_state = {};
+      };
+
+      /**/ /*  */ stats_sink();
+      /**/ /*  */ ~stats_sink();
+      /**/ inline stats_sink(stats_sink const &)          = delete;
+      auto inline operator=(stats_sink const &) -> stats_sink & = delete;
+
+      auto /*  */ make_table(std::string title) -> table;
+      auto /*  */ set_output(format value, std::filesystem::path const &path = {}) -> void; /* empty path is stdout */
+      auto /*  */ set_period(duration value) -> void;
+      auto /*  */ poll() -> void; /* renders when due on targets without worker threads, no-op otherwise */
+      auto /*  */ flush() -> void; /* renders now */
+
+    private:
+      auto /*  */ render(std::unique_lock<std::mutex> &lock) -> void;
+      auto /*  */ start(std::unique_lock<std::mutex> &lock) -> void; /* the render thread, once there is something to render */
+
+      std::mutex /*                          */ m_mutex       = {};
+      std::vector<std::weak_ptr<table_state>> m_tables      = {};
+      format /*                              */ m_format      = format::ansi_table;
+      std::ofstream /*                       */ m_file        = {};
+      bool /*                                */ m_csv_header  = false; /* written to the current output */
+      duration /*                            */ m_period      = std::chrono::milliseconds{250};
+      clock::time_point /*                   */ m_epoch       = clock::now(),
+                                                 m_next_render = clock::now();
+#if /* */ not defined(__EMSCRIPTEN__)
+      std::condition_variable_any /*         */ m_wake        = {};
+      std::jthread /*                        */ m_thread      = {}; /* declared last, joined before the rest is destroyed */
+#endif // not defined(__EMSCRIPTEN__)
+  };
+} // namespace engine::utilities
+
+#endif // ENGINE_STATS_SINK_HPP
@@ -0,0 +1,199 @@
+#ifndef ENGINE_TASK_HPP
+#define ENGINE_TASK_HPP
+
+#include <engine/core.hpp>
+#include <engine/renderer.hpp>
+#include <engine/utilities.hpp>
+
+#include <condition_variable>
+#include <deque>
+
+namespace engine
+{
+  /* Coroutine frames come from a shared pool instead of the general heap. */
+  struct task_promise_base
+  {
+    public:
+      auto static operator new(size_t size) -> void * { return frame_resource().allocate(size); }
+      auto static operator delete(void *frame, size_t size) noexcept -> void { frame_resource().deallocate(frame, size); }
+      auto static frame_resource() noexcept -> std::pmr::memory_resource &;
+
+      struct final_awaiter
+      {
+          auto inline await_ready() const noexcept -> bool { return false; }
+          template <typename promise_t>
+          auto inline await_suspend(std::coroutine_handle<promise_t> handle) const noexcept -> std::coroutine_handle<> { return handle.promise().continuation; }
+          auto inline await_resume() const noexcept -> void {}
+      };
+      auto inline initial_suspend() const noexcept -> std::suspend_always { return {}; } /* started by `co_await` or `coroutine_scheduler::spawn` */
+      auto inline final_suspend() const noexcept -> final_awaiter { return {}; }
+      auto inline unhandled_exception() noexcept -> void { exception = std::current_exception(); }
+
+      std::coroutine_handle<> continuation = std::noop_coroutine();
+      std::exception_ptr /**/ exception    = {};
+  };
+  template <typename T>
+  struct task;
+  template <typename T>
+  struct task_promise : task_promise_base
+  {
+      template <typename U>
+        requires(std::constructible_from<T, U>)
+      auto inline return_value(U &&value) -> void { result.emplace(std::forward<U>(value)); }
+      auto inline get_return_object() noexcept -> task<T>;
+      auto inline get_result() -> T
+      {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*result);
+      }
+      std::optional<T> result = {};
+  };
+  template <>
+  struct task_promise<void> : task_promise_base
+  {
+      auto inline return_void() const noexcept -> void {}
+      auto inline get_return_object() noexcept -> task<void>;
+      auto inline get_result() const -> void { if (exception) std::rethrow_exception(exception); }
+  };
+
+  /* Lazily started coroutine. `co_await`ing it runs it to completion and resumes the awaiter right after, without going through the loop. */
+  template <typename T = void>
+  struct [[nodiscard]] task
+  {
+    public:
+      using promise_type = task_promise<T>;
+      using handle_t     = std::coroutine_handle<promise_type>;
+
+      /**/ inline task() noexcept {}
+      /**/ inline explicit task(handle_t handle) noexcept : m_handle{handle} {}
+      /**/ inline task(task /* */ &&o) noexcept : m_handle{std::exchange(o.m_handle, {})} {}
+      /**/ inline task(task const &o) noexcept = delete;
+      auto inline operator=(task /* */ &&o) noexcept -> task & { return this->~task(), *new (this) task{std::move(o)}; }
+      auto inline operator=(task const &o) -> task & = delete;
+      /**/ inline ~task()
+      {
+        if (m_handle) m_handle.destroy();
+      }
+
+      auto inline operator co_await() && noexcept
+      {
+        struct awaiter
+        {
+            handle_t handle;
+            auto inline await_ready() const noexcept -> bool { return not handle or handle.done(); } /* empty tasks throw from `await_resume` */
+            auto inline await_suspend(std::coroutine_handle<> awaiting) const -> std::coroutine_handle<> { return runtime_assert(handle, "co_await on an empty {}", "task").promise().continuation = awaiting, handle; }
+            auto inline await_resume() const -> T { return runtime_assert(handle, "co_await on an empty {}", "task").promise().get_result(); }
+        };
+        return awaiter{m_handle};
+      }
+      auto inline is_done /* */ () const noexcept -> bool { return not m_handle or m_handle.done(); }
+      auto inline get_handle () const noexcept -> handle_t { return m_handle; }
+
+    private:
+      handle_t m_handle = {};
+  };
+  template <typename T>
+  auto inline task_promise<T>::get_return_object() noexcept -> task<T> { return task<T>{task<T>::handle_t::from_promise(*this)}; }
+  auto inline task_promise<void>::get_return_object() noexcept -> task<void> { return task<void>{task<void>::handle_t::from_promise(*this)}; }
+
+  /* Owns spawned tasks and resumes them from the main loop: next frame, after a delay, once a gpu fence signals or after a worker pool job. */
+  struct coroutine_scheduler
+  {
+    public:
+      using clock    = std::chrono::steady_clock;
+      using duration = std::chrono::duration<double>;
+
+      struct next_frame_awaiter
+      {
+          coroutine_scheduler *scheduler;
+          auto inline await_ready() const noexcept -> bool { return false; }
+          auto inline await_suspend(std::coroutine_handle<> handle) const -> void { scheduler->m_next_frame.push_back(handle); }
+          auto inline await_resume() const noexcept -> void {}
+      };
+      struct delay_awaiter
+      {
+          coroutine_scheduler *scheduler;
+          clock::time_point    deadline;
+          auto inline await_ready() const noexcept -> bool { return deadline <= clock::now(); }
+          auto /*  */ await_suspend(std::coroutine_handle<> handle) const -> void;
+          auto inline await_resume() const noexcept -> void {}
+      };
+      struct gpu_fence_awaiter
+      {
+          coroutine_scheduler *scheduler;
+          GLsync /*         */ sync; /* deleted on resumption */
+          auto /*  */ await_ready() const noexcept -> bool;
+          auto inline await_suspend(std::coroutine_handle<> handle) const -> void { scheduler->m_fences.emplace_back(sync, handle); }
+          auto inline await_resume() const noexcept -> void { glDeleteSync(sync); }
+      };
+      template <typename F>
+      struct worker_awaiter
+      {
+          using result_t = std::invoke_result_t<F &>;
+          coroutine_scheduler *scheduler;
+          F /*              */ job;
+          std::conditional_t<std::is_void_v<result_t>, std::monostate, std::optional<result_t>>
+              /*            */ result    = {};
+          std::exception_ptr   exception = {};
+          auto inline await_ready() const noexcept -> bool { return false; }
+          auto inline await_suspend(std::coroutine_handle<> handle) -> void
+          {
+            scheduler->submit([this, handle]
+                              {
+                                try
+                                {
+                                  if constexpr (std::is_void_v<result_t>) std::invoke(job);
+                                  else result.emplace(std::invoke(job));
+                                }
+                                catch (...)
+                                {
+                                  exception = std::current_exception();
+                                }
+                                scheduler->resume_on_main(handle);
+                              });
+          }
+          auto inline await_resume() -> result_t
+          {
+            if (exception) std::rethrow_exception(exception);
+            if constexpr (not std::is_void_v<result_t>) return std::move(*result);
+          }
+      };
+
+      /**/ inline coroutine_scheduler() noexcept {}
+      /**/ /*  */ ~coroutine_scheduler();
+      /**/ inline coroutine_scheduler(coroutine_scheduler const &)            = delete; /* awaiters point at it */
+      auto inline operator=(coroutine_scheduler const &) -> coroutine_scheduler & = delete;
+
+      auto /*  */ spawn(task<void> value) -> void; /* runs until its first suspension right away */
+      auto /*  */ clear() -> void;                 /* joins the worker pool, then destroys unfinished tasks */
+      auto /*  */ resume_due() -> void;            /* main thread, once per frame */
+      auto /*  */ next_deadline() const -> std::optional<clock::time_point>;
+      auto inline get_task_count() const noexcept -> size_t { return m_tasks.size(); }
+
+      auto inline next_frame /*     */ () noexcept -> next_frame_awaiter { return {this}; }
+      auto inline delay /*          */ (duration value) noexcept -> delay_awaiter { return {this, clock::now() + std::chrono::duration_cast<clock::duration>(value)}; }
+      auto inline gpu_fence /*      */ (GLsync sync) noexcept -> gpu_fence_awaiter { return {this, sync}; }
+      template <typename F>
+        requires(std::invocable<F &>)
+      auto inline on_worker_pool /* */ (F &&job) -> worker_awaiter<std::decay_t<F>> { return {this, std::forward<F>(job)}; }
+
+    private:
+      using delayed_t = std::pair<clock::time_point, std::coroutine_handle<>>;
+      auto /*  */ submit(std::function<void()> job) -> void;
+      auto /*  */ resume_on_main(std::coroutine_handle<> handle) -> void; /* any thread */
+
+      std::vector<task<void>> /*                         */ m_tasks        = {};
+      std::vector<std::coroutine_handle<>> /*            */ m_next_frame   = {};
+      std::vector<delayed_t> /*                          */ m_delayed      = {}; /* min heap on the deadline */
+      std::vector<std::pair<GLsync, std::coroutine_handle<>>> m_fences       = {};
+      std::mutex /*                                      */ m_mutex        = {};
+      std::vector<std::coroutine_handle<>> /*            */ m_from_workers = {};
+      std::deque<std::function<void()>> /*               */ m_jobs         = {};
+#if /* */ not defined(__EMSCRIPTEN__)
+      std::condition_variable_any /*                     */ m_wake         = {};
+      std::vector<std::jthread> /*                       */ m_workers      = {}; /* started on the first job, declared last and joined first */
+#endif // not defined(__EMSCRIPTEN__)
+  };
+} // namespace engine
+
+#endif // ENGINE_TASK_HPP
@@ -0,0 +1,176 @@
+#ifndef ENGINE_TIMER_WHEEL_HPP
+#define ENGINE_TIMER_WHEEL_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+namespace engine::utilities
+{
+  /* Hashed timer wheel over stable slots. Entries within one tick fire in scheduling order, far deadlines wait in an overflow list. */
+  template <typename T>
+  struct timer_wheel
+  {
+    public:
+      using clock  = std::chrono::steady_clock;
+      using slot_t = uint32_t;
+      auto inline static constexpr s_npos         = std::numeric_limits<slot_t>::max();
+      auto inline static constexpr s_tick         = std::chrono::milliseconds{1};
+      auto inline static constexpr s_bucket_count = 256zu; /* power of two, the horizon of the wheel in ticks */
+      struct due
+      {
+          slot_t /*      */ slot     = s_npos;
+          clock::time_point deadline = {};
+      };
+
+      /**/ inline explicit timer_wheel(clock::time_point origin = clock::now()) noexcept : m_origin{origin} {}
+
+      auto inline add(T value) -> slot_t /* unscheduled until `schedule` */
+      {
+        auto const slot = m_free.empty() ? static_cast<slot_t>(m_entries.size()) : m_free.back();
+        if (m_free.empty()) m_entries.emplace_back();
+        else m_free.pop_back();
+        m_entries[slot] = entry{.value = std::move(value), .live = true};
+        return slot;
+      }
+      auto inline remove(slot_t slot) -> void
+      {
+        cancel(slot);
+        m_entries.at(slot) = entry{};
+        m_free.push_back(slot);
+      }
+      auto inline schedule(slot_t slot, clock::time_point deadline) -> void
+      {
+        cancel(slot);
+        auto &entry    = live_entry(slot);
+        entry.deadline = deadline;
+        entry.tick     = std::max(tick_of(deadline), m_cursor);
+        link(slot, entry.tick - m_cursor < static_cast<int64_t>(s_bucket_count) ? bucket_of(entry.tick) : s_overflow);
+      }
+      auto inline cancel(slot_t slot) -> void
+      {
+        if (live_entry(slot).list != s_unlinked) unlink(slot);
+      }
+      /* the earliest scheduled entry due no later than `limit`, unscheduled on return */
+      auto inline pop(clock::time_point limit) -> std::optional<due>
+      {
+        auto const limit_tick = tick_of(limit);
+        while (m_cursor <= limit_tick)
+        {
+          if (m_in_buckets == 0zu) /* nothing to walk through until the next overflow cascade */
+          {
+            auto const next_revolution = (m_cursor / static_cast<int64_t>(s_bucket_count) + 1) * static_cast<int64_t>(s_bucket_count);
+            if (next_revolution > limit_tick) return m_cursor = limit_tick, std::nullopt;
+            advance_to(next_revolution);
+            continue;
+          }
+          auto found_this_tick = false;
+          for (auto slot = m_heads[bucket_of(m_cursor)]; slot != s_npos; slot = m_entries[slot].next)
+          {
+            auto const &entry = m_entries[slot];
+            if (entry.tick != m_cursor) continue;
+            found_this_tick = true;
+            if (entry.deadline > limit) continue;
+            unlink(slot);
+            return due{.slot = slot, .deadline = entry.deadline};
+          }
+          if (found_this_tick) return std::nullopt; /* due later within the limit's own tick */
+          advance_to(m_cursor + 1);
+        }
+        return std::nullopt;
+      }
+      auto inline next_deadline() const -> std::optional<clock::time_point>
+      {
+        for (auto const tick : std::views::iota(m_cursor, m_cursor + static_cast<int64_t>(s_bucket_count)))
+        {
+          if (m_in_buckets == 0zu) break;
+          auto result = std::optional<clock::time_point>{};
+          for (auto slot = m_heads[bucket_of(tick)]; slot != s_npos; slot = m_entries[slot].next)
+            if (m_entries[slot].tick == tick) result = std::min(result.value_or(clock::time_point::max()), m_entries[slot].deadline);
+          if (result) return result;
+        }
+        auto result = std::optional<clock::time_point>{};
+        for (auto slot = m_heads[s_overflow]; slot != s_npos; slot = m_entries[slot].next)
+          result = std::min(result.value_or(clock::time_point::max()), m_entries[slot].deadline);
+        return result;
+      }
+      template <typename F>
+        requires(std::predicate<F, T const &>)
+      auto inline remove_if(F &&predicate) -> void /* linear in slots, meant for bulk changes */
+      {
+        for (auto const slot : std::views::iota(slot_t{0}, static_cast<slot_t>(m_entries.size())))
+          if (m_entries[slot].live and std::invoke(predicate, std::as_const(m_entries[slot].value))) remove(slot);
+      }
+      auto inline is_live /*     */ (slot_t slot) const noexcept -> bool { return slot < m_entries.size() and m_entries[slot].live; }
+      auto inline is_scheduled /**/ (slot_t slot) const noexcept -> bool { return is_live(slot) and m_entries[slot].list != s_unlinked; }
+      auto inline get /*         */ (slot_t slot) /* */ -> T /* */ & { return live_entry(slot).value; }
+      auto inline get /*         */ (slot_t slot) const -> T const & { return live_entry(slot).value; }
+
+    private:
+      auto inline static constexpr s_overflow = static_cast<uint32_t>(s_bucket_count);
+      auto inline static constexpr s_unlinked = std::numeric_limits<uint32_t>::max();
+      static_assert(std::has_single_bit(s_bucket_count));
+      struct entry
+      {
+          T /*           */ value    = {};
+          clock::time_point deadline = {};
+          int64_t /*     */ tick     = 0;
+          slot_t /*      */ prev     = s_npos,
+                            next     = s_npos;
+          uint32_t /*    */ list     = s_unlinked; /* bucket index, `s_overflow` or `s_unlinked` */
+          bool /*        */ live     = false;
+      };
+      auto inline static constexpr bucket_of(int64_t tick) noexcept -> uint32_t { return static_cast<uint32_t>(static_cast<uint64_t>(tick) & (s_bucket_count - 1zu)); }
+      auto inline tick_of(clock::time_point time) const noexcept -> int64_t
+      {
+        if (time == clock::time_point::max()) return std::numeric_limits<int64_t>::max();
+        return std::chrono::floor<std::chrono::milliseconds>(time - m_origin).count() / s_tick.count();
+      }
+      auto inline live_entry(slot_t slot) -> entry & { return *runtime_assert(is_live(slot) ? &m_entries[slot] : nullptr, "timer wheel slot {} is not live", slot); }
+      auto inline live_entry(slot_t slot) const -> entry const & { return *runtime_assert(is_live(slot) ? &m_entries[slot] : nullptr, "timer wheel slot {} is not live", slot); }
+      auto inline link(slot_t slot, uint32_t list) -> void /* appends, keeping scheduling order within a tick */
+      {
+        auto &entry = m_entries[slot];
+        entry.list  = list;
+        entry.prev  = m_tails[list];
+        entry.next  = s_npos;
+        (entry.prev == s_npos ? m_heads[list] : m_entries[entry.prev].next) = slot;
+        m_tails[list] = slot;
+        if (list != s_overflow) m_in_buckets++;
+      }
+      auto inline unlink(slot_t slot) -> void
+      {
+        auto &entry = m_entries[slot];
+        (entry.prev == s_npos ? m_heads[entry.list] : m_entries[entry.prev].next) = entry.next;
+        (entry.next == s_npos ? m_tails[entry.list] : m_entries[entry.next].prev) = entry.prev;
+        if (entry.list != s_overflow) m_in_buckets--;
+        entry.list = s_unlinked, entry.prev = entry.next = s_npos;
+      }
+      auto inline advance_to(int64_t tick) -> void /* cascades the overflow list on every revolution */
+      {
+        m_cursor = tick;
+        if (m_cursor % static_cast<int64_t>(s_bucket_count) != 0) return;
+        for (auto slot = m_heads[s_overflow]; slot != s_npos;)
+        {
+          auto const next = m_entries[slot].next;
+          if (m_entries[slot].tick - m_cursor < static_cast<int64_t>(s_bucket_count))
+            unlink(slot), link(slot, bucket_of(m_entries[slot].tick));
+          slot = next;
+        }
+      }
+
+      clock::time_point /*                     */ m_origin     = {};
+      int64_t /*                               */ m_cursor     = 0; /* ticks before it are done */
+      size_t /*                                */ m_in_buckets = 0zu;
+      std::vector<entry> /*                    */ m_entries    = {};
+      std::vector<slot_t> /*                   */ m_free       = {};
+      std::array<slot_t, s_bucket_count + 1zu> m_heads      = filled(s_npos),
+                                                 m_tails      = filled(s_npos);
+      auto inline static constexpr filled(slot_t value) noexcept
+      {
+        auto result = std::array<slot_t, s_bucket_count + 1zu>{};
+        return result.fill(value), result;
+      }
+  };
+} // namespace engine::utilities
+
+#endif // ENGINE_TIMER_WHEEL_HPP
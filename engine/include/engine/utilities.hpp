@@ -33,6 +33,14 @@ namespace engine::utilities
                       range.subspan(/**/ unsorted_size)};
   }
 
+  auto inline constexpr hash_fnv1a_offset_basis = uint64_t{0xCB'F2'9C'E4'84'22'23'25u};
+  auto inline constexpr hash_fnv1a_prime        = uint64_t{0x00'00'01'00'00'00'01'B3u};
+  auto /*  */ constexpr hash_fnv1a(std::string_view const bytes, uint64_t hash = hash_fnv1a_offset_basis) noexcept -> uint64_t
+  {
+    for (auto const c : bytes) hash = (hash xor static_cast<uint8_t>(c)) * hash_fnv1a_prime;
+    return hash;
+  }
+
   template <typename T>
   auto inline constexpr static_cast_lambda = []<typename U>(U &&value) static
     requires std::constructible_from<T, U>
@@ -58,8 +66,51 @@ namespace engine::utilities
       std::variant<std::string_view, intmax_t, uintmax_t, double_t> variant = "";
   };
   auto inline constexpr print_table_lines_inline_buffer_count = 16zu;
-  auto /*  */ /*     */ print_ansi_table_from_spans(std::span<std::span<print_table_column_t const> const> const lines) -> void;
-  auto /*  */ /*     */ print_ansi_table(std::initializer_list<std::initializer_list<print_table_column_t>> lines) -> void;
+  auto /*  */ /*     */ print_ansi_table_from_spans(std::span<std::span<print_table_column_t const> const> const lines, std::FILE *stream = stdout) -> void;
+  auto /*  */ /*     */ print_ansi_table(std::initializer_list<std::initializer_list<print_table_column_t>> lines, std::FILE *stream = stdout) -> void;
+
+  /* Two monotonic arenas used on alternating frames. Memory handed out during a frame stays valid through the next one. */
+  struct frame_arena
+  {
+    public:
+      auto inline static constexpr s_initial_capacity = 64zu * 1024zu;
+
+      /**/ /*  */ frame_arena();
+      /**/ inline frame_arena(frame_arena const &)            = delete; /* the resources point into their own arena */
+      auto inline operator=(frame_arena const &) -> frame_arena & = delete;
+
+      auto /*  */ begin_frame() -> void; /* recycles the arena of two frames ago, growing it if that frame spilled */
+      auto inline get_resource /* */ () noexcept -> std::pmr::memory_resource * { return &*m_arenas.at(m_current).resource; }
+      auto inline get_capacity /* */ () const noexcept -> size_t { return m_arenas.at(m_current).capacity; }
+      auto inline get_spilled /*  */ () const noexcept -> size_t { return m_arenas.at(m_current).upstream.bytes; } /* bytes past capacity this frame */
+
+    private:
+      struct counting_resource : std::pmr::memory_resource
+      {
+          size_t bytes = 0zu;
+          auto do_allocate(size_t size, size_t alignment) -> void * override { return bytes += size, std::pmr::new_delete_resource()->allocate(size, alignment); }
+          auto do_deallocate(void *p, size_t size, size_t alignment) -> void override { std::pmr::new_delete_resource()->deallocate(p, size, alignment); }
+          auto do_is_equal(std::pmr::memory_resource const &o) const noexcept -> bool override { return this == &o; }
+      };
+      struct arena
+      {
+          std::unique_ptr<std::byte[]> /*                     */ buffer   = {};
+          size_t /*                                           */ capacity = 0zu;
+          counting_resource /*                                */ upstream = {};
+          std::optional<std::pmr::monotonic_buffer_resource> resource = {};
+          auto /*  */ reset(size_t new_capacity) -> void;
+      };
+      std::array<arena, 2zu> m_arenas  = {};
+      size_t /*           */ m_current = 0zu;
+  };
+  /* re-seats an arena backed container on another resource, dropping its contents */
+  template <typename T>
+  auto inline rebind(T &container, std::pmr::memory_resource *resource) -> T &
+  {
+    return std::destroy_at(&container), *std::construct_at(&container, resource);
+  }
+
+  auto /*  */ /*     */ demangle(char const *const name) -> std::string; /* readable `typeid` names where the abi allows */
 
   auto /*  */ /*     */ read_all(char const *const /*      */ file_path, char const *const mode = "r") -> std::expected<std::string, std::error_code>;
   auto inline /*     */ read_all(std::filesystem::path const &file_path, char const *const mode = "r") -> decltype(read_all(file_path.string().c_str(), mode))
@@ -70,6 +121,39 @@ namespace engine::utilities
       return read_all(file_path.string().c_str(), mode);
   }
 
+  /* Read-only view of a whole file, memory mapped where the platform allows and read into memory otherwise. */
+  struct mapped_file
+  {
+    public:
+      /**/ inline mapped_file() noexcept {}
+      /**/ inline mapped_file(mapped_file /* */ &&o) noexcept
+      {
+        m_data     = std::exchange(o.m_data /*     */, {});
+        m_size     = std::exchange(o.m_size /*     */, {});
+        m_mapped   = std::exchange(o.m_mapped /*   */, {});
+        m_fallback = std::exchange(o.m_fallback /* */, {});
+        if (not m_mapped) m_data = reinterpret_cast<std::byte const *>(m_fallback.data()); /* small strings move their bytes */
+      }
+      /**/ inline mapped_file(mapped_file const &&o) noexcept = delete;
+      auto inline operator=(mapped_file /* */ &&o) noexcept -> mapped_file & { return this->~mapped_file(), *new (this) mapped_file{std::move(o)}; }
+      auto inline operator=(mapped_file const &o) -> mapped_file & = delete;
+      /**/ /*  */ ~mapped_file();
+
+      auto static open(std::filesystem::path const &file_path) -> std::expected<mapped_file, std::error_code>;
+      auto inline data /*      */ () const noexcept -> std::byte const * { return m_data; }
+      auto inline size /*      */ () const noexcept -> size_t { return m_size; }
+      auto inline empty /*     */ () const noexcept -> bool { return m_size == 0zu; }
+      auto inline bytes /*     */ () const noexcept -> std::span<std::byte const> { return {m_data, m_size}; }
+      auto inline view /*      */ () const noexcept -> std::string_view { return {reinterpret_cast<char const *>(m_data), m_size}; }
+      auto inline is_mapped /* */ () const noexcept -> bool { return m_mapped; }
+
+    private:
+      std::byte const *m_data     = nullptr;
+      size_t /*     */ m_size     = 0zu;
+      bool /*       */ m_mapped   = false;
+      std::string /* */ m_fallback = {};
+  };
+
 } // namespace engine::utilities
 namespace engine { using utilities::runtime_assert; }
 
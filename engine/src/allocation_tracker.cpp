@@ -0,0 +1,120 @@
+#include <engine/allocation_tracker.hpp>
+
+#if /* */ defined(ENGINE_ALLOCATION_TRACKER)
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  using namespace engine::allocation_tracker;
+  struct atomic_counters
+  {
+      std::atomic<uint64_t> allocations   = 0u,
+                            deallocations = 0u,
+                            bytes         = 0u;
+      auto exchange() noexcept -> counters
+      {
+        return {
+            .allocations   = allocations.exchange(0u, std::memory_order_relaxed),
+            .deallocations = deallocations.exchange(0u, std::memory_order_relaxed),
+            .bytes         = bytes.exchange(0u, std::memory_order_relaxed),
+        };
+      }
+  };
+  struct layer_slot
+  {
+      std::atomic<char const *> name     = nullptr;
+      atomic_counters /*     */ counters = {};
+  };
+  /* plain globals, zero initialized before any allocation can happen */
+  constinit auto s_phases          = std::array<atomic_counters, s_phase_count>{};
+  constinit auto s_violations      = std::array<std::atomic<bool>, s_phase_count>{};
+  constinit auto s_allocation_free = std::array<std::atomic<bool>, s_phase_count>{};
+  constinit auto s_layers          = std::array<layer_slot, s_layer_slots>{};
+  constinit thread_local auto t_phase      = phase::other;
+  constinit thread_local auto t_layer      = static_cast<layer_slot *>(nullptr);
+  constinit thread_local auto t_layer_name = static_cast<char const *>(nullptr);
+
+  auto on_allocate(size_t size) noexcept -> void
+  {
+    auto const phase_index = static_cast<size_t>(t_phase);
+    s_phases[phase_index].allocations.fetch_add(1u, std::memory_order_relaxed);
+    s_phases[phase_index].bytes.fetch_add(size, std::memory_order_relaxed);
+    if (s_allocation_free[phase_index].load(std::memory_order_relaxed)) s_violations[phase_index].store(true, std::memory_order_relaxed);
+    if (not t_layer) return;
+    t_layer->counters.allocations.fetch_add(1u, std::memory_order_relaxed);
+    t_layer->counters.bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  auto on_deallocate() noexcept -> void
+  {
+    s_phases[static_cast<size_t>(t_phase)].deallocations.fetch_add(1u, std::memory_order_relaxed);
+    if (t_layer) t_layer->counters.deallocations.fetch_add(1u, std::memory_order_relaxed);
+  }
+  auto allocate(size_t size, size_t alignment) -> void *
+  {
+    on_allocate(size);
+    size = std::max(size, 1zu);
+#if /* */ defined(_WIN32) or defined(_WIN64)
+    auto const p = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? ::_aligned_malloc(size, alignment) : std::malloc(size);
+#else  // defined(_WIN32) or defined(_WIN64)
+    auto const p = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? std::aligned_alloc(alignment, (size + alignment - 1zu) / alignment * alignment) : std::malloc(size);
+#endif // defined(_WIN32) or defined(_WIN64)
+    if (not p) throw std::bad_alloc{};
+    return p;
+  }
+  auto deallocate(void *p, size_t alignment) noexcept -> void
+  {
+    if (not p) return;
+    on_deallocate();
+#if /* */ defined(_WIN32) or defined(_WIN64)
+    alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? ::_aligned_free(p) : std::free(p);
+#else  // defined(_WIN32) or defined(_WIN64)
+    (void)alignment, std::free(p);
+#endif // defined(_WIN32) or defined(_WIN64)
+  }
+} // namespace
+
+/* the remaining replaceable forms (array, nothrow, sized) forward to these by default */
+auto operator new(size_t size) -> void * { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+auto operator new(size_t size, std::align_val_t alignment) -> void * { return allocate(size, static_cast<size_t>(alignment)); }
+auto operator delete(void *p) noexcept -> void { deallocate(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+auto operator delete(void *p, std::align_val_t alignment) noexcept -> void { deallocate(p, static_cast<size_t>(alignment)); }
+
+auto engine::allocation_tracker::set_phase(phase value) noexcept -> phase
+{
+  return std::exchange(t_phase, value);
+}
+auto engine::allocation_tracker::set_layer(char const *name) noexcept -> char const *
+{
+  auto const previous = std::exchange(t_layer_name, name);
+  if (not name) return t_layer = nullptr, previous;
+  for (auto &slot : s_layers)
+  {
+    auto expected = static_cast<char const *>(nullptr);
+    if (slot.name.load(std::memory_order_acquire) == name or
+        slot.name.compare_exchange_strong(expected, name, std::memory_order_acq_rel) or
+        expected == name) return t_layer = &slot, previous;
+  }
+  return t_layer = &s_layers.front(), previous;
+}
+auto engine::allocation_tracker::set_allocation_free(phase value, bool allocation_free) noexcept -> void
+{
+  s_allocation_free.at(static_cast<size_t>(value)).store(allocation_free, std::memory_order_relaxed);
+}
+auto engine::allocation_tracker::end_frame() -> frame_report
+{
+  auto report = frame_report{};
+  for (auto const i : std::views::iota(0zu, s_phase_count))
+  {
+    report.phases[i]     = s_phases[i].exchange();
+    report.violations[i] = s_violations[i].exchange(false, std::memory_order_relaxed);
+  }
+  for (auto &slot : s_layers)
+    if (auto const name = slot.name.load(std::memory_order_acquire))
+      if (auto const counters = slot.counters.exchange(); counters.allocations or counters.deallocations)
+        report.layers[report.layer_count++] = {name, counters};
+  return report;
+}
+
+#endif // defined(ENGINE_ALLOCATION_TRACKER)
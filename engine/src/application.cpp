@@ -1,5 +1,6 @@
 #include <engine/application.hpp>
 #include <engine/events.hpp>
+#include <engine/profiler.hpp>
 
 #if /* */ defined(INIT_GLAD) or defined(RUN_MAIN_LOOP)
 #error "Macro name collision"
@@ -25,185 +26,497 @@
 #define RUN_MAIN_LOOP []<typename T>(T &main_loop) static { while (main_loop()); }
 #endif // defined(__EMSCRIPTEN__)
 
-engine::application::application()
+auto engine::application::options::parse(std::span<char const *const> args) -> options
+{
+  auto const parse_number = [](std::string_view name, std::string_view value) static -> size_t
+  {
+    auto number            = size_t{};
+    auto const [end, code] = std::from_chars(value.data(), value.data() + value.size(), number);
+    runtime_assert<std::invalid_argument>(code == std::errc{} and end == value.data() + value.size(), "invalid {} {:?}", name, value);
+    return number;
+  };
+  auto result = options{};
+  for (auto const argument : args | std::views::drop(1) | std::views::transform([](char const *arg) static { return std::string_view{arg}; }))
+  {
+    auto const split = argument.find('=');
+    auto const key   = argument.substr(0zu, split);
+    auto const value = split == std::string_view::npos ? std::string_view{} : argument.substr(split + 1zu);
+    if /*   */ (key == "--backend")
+    {
+      auto static constexpr backends = std::array{
+          std::pair{std::string_view{"window"}, backend_t::window},
+          std::pair{std::string_view{"headless"}, backend_t::headless},
+          std::pair{std::string_view{"no_render"}, backend_t::no_render},
+      };
+      auto const it = std::ranges::find(backends, value, &decltype(backends)::value_type::first);
+      runtime_assert<std::invalid_argument>(it != backends.end(), "unknown backend {:?}", value);
+      result.backend = it->second;
+    }
+    else if (key == "--size")
+    {
+      auto const x = value.find('x');
+      runtime_assert<std::invalid_argument>(x != std::string_view::npos, "invalid size {:?}, expected <width>x<height>", value);
+      result.size = glm::ivec2{parse_number("width", value.substr(0zu, x)), parse_number("height", value.substr(x + 1zu))};
+      runtime_assert<std::invalid_argument>(result.size.x > 0 and result.size.y > 0, "invalid size {:?}", value);
+    }
+    else if (key == "--frames") result.max_frames = parse_number("frame count", value);
+    else if (key == "--ticks") result.max_ticks = parse_number("tick count", value);
+    else if (key == "--trace") result.trace_path = value;
+    else if (key == "--stats")
+    {
+      using format_t                = utilities::stats_sink::format;
+      auto static constexpr formats = std::array{
+          std::pair{std::string_view{"ansi"}, format_t::ansi_table},
+          std::pair{std::string_view{"csv"}, format_t::csv},
+          std::pair{std::string_view{"jsonl"}, format_t::jsonl},
+          std::pair{std::string_view{"none"}, format_t::none},
+      };
+      auto const it = std::ranges::find(formats, value, &decltype(formats)::value_type::first);
+      runtime_assert<std::invalid_argument>(it != formats.end(), "unknown stats format {:?}", value);
+      result.stats_format = it->second;
+    }
+    else if (key == "--stats-file") result.stats_path = value;
+    else if (key == "--capture") result.capture_path = value;
+    else if (key == "--record") result.record_path = value;
+    else if (key == "--replay") result.replay_path = value;
+    else if (key == "--seed") result.seed = parse_number("seed", value);
+    else if (key == "--gl-check")
+    {
+      using check_level_t          = utilities::gl::check_level;
+      auto static constexpr levels = std::array{
+          std::pair{std::string_view{"off"}, check_level_t::off},
+          std::pair{std::string_view{"per_frame"}, check_level_t::per_frame},
+          std::pair{std::string_view{"per_call"}, check_level_t::per_call},
+      };
+      auto const it = std::ranges::find(levels, value, &decltype(levels)::value_type::first);
+      runtime_assert<std::invalid_argument>(it != levels.end(), "unknown gl check level {:?}", value);
+      result.gl_check = it->second;
+    }
+    else if (key == "--viewport-fit")
+    {
+      auto static constexpr fits = std::array{
+          std::pair{std::string_view{"cover"}, viewport_fit::cover},
+          std::pair{std::string_view{"contain"}, viewport_fit::contain},
+          std::pair{std::string_view{"stretch"}, viewport_fit::stretch},
+      };
+      auto const it = std::ranges::find(fits, value, &decltype(fits)::value_type::first);
+      runtime_assert<std::invalid_argument>(it != fits.end(), "unknown viewport fit {:?}", value);
+      result.fit = it->second;
+    }
+    else if (key == "--render-scale")
+    {
+      auto const [end, code] = std::from_chars(value.data(), value.data() + value.size(), result.min_render_scale);
+      runtime_assert<std::invalid_argument>(code == std::errc{} and end == value.data() + value.size(), "invalid {} {:?}", "render scale", value);
+      runtime_assert<std::invalid_argument>(0.0 < result.min_render_scale and result.min_render_scale <= 1.0, "render scale {:?} is outside of (0, 1]", value);
+    }
+    else if (key == "--allocation-free")
+    {
+      for (auto const phase : value | std::views::split(',') | std::views::transform([](auto &&range) static { return std::string_view{range}; }))
+      {
+        auto const it = std::ranges::find(allocation_tracker::s_phase_names, phase);
+        runtime_assert<std::invalid_argument>(it != allocation_tracker::s_phase_names.end(), "unknown phase {:?}", phase);
+        result.allocation_free.at(static_cast<size_t>(it - allocation_tracker::s_phase_names.begin())) = true;
+      }
+    }
+    else runtime_assert<std::invalid_argument>(false, "unknown option {:?}", argument);
+  }
+  return result;
+}
+auto engine::application::set_frame_pacing_mode(frame_pacer::mode value) -> void
+{
+  m_frame_pacer.set_mode(value);
+  glfwSwapInterval(value == frame_pacer::mode::vsync ? 1 : 0);
+}
+engine::application::application() : application(options{}) {}
+engine::application::application(options const &config) : m_options{config}
 {
   runtime_assert(not s_instance, "application singleton violation");
-  s_instance = this;
+  s_instance          = this;
+  auto const windowed = m_options.backend == options::backend_t::window;
+  m_stats.set_output(m_options.stats_format, m_options.stats_path);
+  m_render_target.set_fit(m_options.fit);
+  m_render_target.set_min_scale(m_options.min_render_scale);
+  for (auto const [i, allocation_free] : std::views::enumerate(m_options.allocation_free))
+    allocation_tracker::set_allocation_free(static_cast<allocation_tracker::phase>(i), allocation_free);
+#if /* */ defined(GLFW_PLATFORM_NULL)
+  if (not windowed) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else  // defined(GLFW_PLATFORM_NULL)
+  runtime_assert(windowed, "{} backends are unavailable on this platform", "display-less");
+#endif // defined(GLFW_PLATFORM_NULL)
   runtime_assert(glfwInit(), "{} init fail", "glfw");
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
   glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
-  m_window = glfwCreateWindow(720, 720, "game", nullptr, nullptr); /* TODO: hardcoded parameters */
+  if (not windowed) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API); /* surfaceless on the null platform */
+  m_window = glfwCreateWindow(m_options.size.x, m_options.size.y, "game", nullptr, nullptr);
   runtime_assert(m_window, "{} init fail", "window");
   glfwMakeContextCurrent(m_window);
   runtime_assert(INIT_GLAD(glfwGetProcAddress), "{} init fail", "glad");
+  if (auto const requested = m_options.gl_check.value_or(utilities::gl::get_check_level());
+      utilities::gl::set_check_level(requested, glfwGetProcAddress) != requested)
+    std::println(stderr, "Error in {:?}: {}", "GL check level", "the requested level is above the compiled ENGINE_GL_CHECK_LEVEL");
+  set_frame_pacing_mode(m_frame_pacer.get_mode());
+  /* offscreen default framebuffer */ if (not windowed)
+  {
+    m_offscreen_framebuffer = m_renderer.framebuffers.make_unique();
+    m_offscreen_color       = m_renderer.renderbuffers.make_unique();
+    glBindRenderbuffer(GL_RENDERBUFFER, m_offscreen_color.get());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_options.size.x, m_options.size.y);
+    m_renderer.state.bind_framebuffer(GL_FRAMEBUFFER, m_offscreen_framebuffer.get());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreen_color.get());
+    runtime_assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "{} init fail", "offscreen framebuffer");
+    m_renderer.state.set_default_framebuffer(m_offscreen_framebuffer.get());
+    glCheckError();
+  }
+  /* input state */ if (true)
+  {
+    glfwGetWindowSize(m_window, &m_input.window_size.x, &m_input.window_size.y);
+    glfwGetFramebufferSize(m_window, &m_input.framebuffer_size.x, &m_input.framebuffer_size.y);
+    glfwGetWindowContentScale(m_window, &m_input.content_scale.x, &m_input.content_scale.y);
+    glfwGetCursorPos(m_window, &m_input.cursor_window.x, &m_input.cursor_window.y);
+    m_input.focused       = glfwGetWindowAttrib(m_window, GLFW_FOCUSED) == GLFW_TRUE;
+    m_input.cursor_inside = glfwGetWindowAttrib(m_window, GLFW_HOVERED) == GLFW_TRUE;
+    fit_viewport();
+  }
+  /* frame capture */ if (not m_options.capture_path.empty())
+  {
+    using format_t    = renderer::frame_capture::format;
+    auto const format = m_options.capture_path.extension() == ".y4m" ? format_t::y4m : format_t::png;
+    m_renderer.capture.start(m_options.capture_path, format, static_cast<uint32_t>(std::round(get_target_render_rate())));
+  }
+  /* event log     */ if (true)
+  {
+    if (not m_options.replay_path.empty()) m_player.emplace(m_options.replay_path, m_window);
+    m_seed = m_player ? m_player->get_seed() : m_options.seed.value_or((uint64_t{std::random_device{}()} << 32u) | std::random_device{}());
+    if (not m_options.record_path.empty())
+    {
+      using namespace engine::events::glfw;
+      m_recorder.emplace(m_options.record_path, m_seed);
+      for (auto const &event : std::array<event_container_t, 4>{
+               window_size_event{m_window, m_input.window_size},
+               framebuffer_size_event{m_window, m_input.framebuffer_size},
+               window_content_scale_event{m_window, m_input.content_scale},
+               cursor_pos_event{m_window, m_input.cursor_window},
+           }) /* the initial input state, replayed on the first frame */
+        m_recorder->write(0u, 0u, event);
+    }
+  }
   /* glfw event callbacks */ if (true)
   {
     using namespace engine::events::glfw;
     glfwSetKeyCallback(
         m_window,
         +[](GLFWwindow *window, int key, int scancode, int action, int mods)
-        { application::get().queue_event(key_event{window, key, scancode, action, mods}); });
+        { application::get().glfw_event(key_event{window, key, scancode, action, mods}); });
     glfwSetCharCallback(
         m_window,
         +[](GLFWwindow *window, unsigned int codepoint)
-        { application::get().queue_event(char_event{window, codepoint}); });
+        { application::get().glfw_event(char_event{window, codepoint}); });
     glfwSetDropCallback(
         m_window,
         +[](GLFWwindow *window, int path_count, const char *paths[])
-        { application::get().queue_event(drop_event{window, std::vector<std::filesystem::path>{paths, paths + path_count}}); });
+        { application::get().glfw_event(drop_event{window, std::vector<std::filesystem::path>{paths, paths + path_count}}); });
     glfwSetScrollCallback(
         m_window,
         +[](GLFWwindow *window, double xoffset, double yoffset)
-        { application::get().queue_event(scroll_event{window, {xoffset, yoffset}}); });
+        { application::get().glfw_event(scroll_event{window, {xoffset, yoffset}}); });
     /* TODO: unimplemented in emscripten. disabled for now. */ if (0)
       glfwSetCharModsCallback(
           m_window,
           +[](GLFWwindow *window, unsigned int codepoint, int mods)
-          { application::get().queue_event(char_mods_event{window, codepoint, mods}); });
+          { application::get().glfw_event(char_mods_event{window, codepoint, mods}); });
     glfwSetCursorPosCallback(
         m_window,
         +[](GLFWwindow *window, double xpos, double ypos)
-        { application::get().queue_event(cursor_pos_event{window, {xpos, ypos}}); });
+        { application::get().glfw_event(cursor_pos_event{window, {xpos, ypos}}); });
     glfwSetWindowPosCallback(
         m_window,
         +[](GLFWwindow *window, int xpos, int ypos)
-        { application::get().queue_event(window_pos_event{window, {xpos, ypos}}); });
+        { application::get().glfw_event(window_pos_event{window, {xpos, ypos}}); });
     glfwSetWindowSizeCallback(
         m_window,
         +[](GLFWwindow *window, int width, int height)
-        { application::get().queue_event(window_size_event{window, {width, height}}); });
+        { application::get().glfw_event(window_size_event{window, {width, height}}); });
     glfwSetCursorEnterCallback(
         m_window,
         +[](GLFWwindow *window, int entered)
-        { application::get().queue_event(cursor_enter_event{window, entered == GLFW_TRUE}); });
+        { application::get().glfw_event(cursor_enter_event{window, entered == GLFW_TRUE}); });
     glfwSetWindowCloseCallback(
         m_window,
         +[](GLFWwindow *window)
-        { application::get().queue_event(window_close_event{window}); });
+        { application::get().glfw_event(window_close_event{window}); });
     glfwSetMouseButtonCallback(
         m_window,
         +[](GLFWwindow *window, int button, int action, int mods)
-        { application::get().queue_event(mouse_button_event{window, button, action, mods}); });
+        { application::get().glfw_event(mouse_button_event{window, button, action, mods}); });
     glfwSetWindowFocusCallback(
         m_window,
         +[](GLFWwindow *window, int focused)
-        { application::get().queue_event(window_focus_event{window, focused == GLFW_TRUE}); });
+        { application::get().glfw_event(window_focus_event{window, focused == GLFW_TRUE}); });
     glfwSetWindowIconifyCallback(
         m_window,
         +[](GLFWwindow *window, int iconified)
-        { application::get().queue_event(window_iconify_event{window, iconified == GLFW_TRUE}); });
+        { application::get().glfw_event(window_iconify_event{window, iconified == GLFW_TRUE}); });
     glfwSetWindowRefreshCallback(
         m_window,
         +[](GLFWwindow *window)
-        { application::get().queue_event(window_refresh_event{window}); });
+        { application::get().glfw_event(window_refresh_event{window}); });
     glfwSetWindowMaximizeCallback(
         m_window,
         +[](GLFWwindow *window, int maximized)
-        { application::get().queue_event(window_maximize_event{window, maximized == GLFW_TRUE}); });
+        { application::get().glfw_event(window_maximize_event{window, maximized == GLFW_TRUE}); });
     glfwSetFramebufferSizeCallback(
         m_window,
         +[](GLFWwindow *window, int width, int height)
-        { application::get().queue_event(framebuffer_size_event{window, {width, height}}); });
+        { application::get().glfw_event(framebuffer_size_event{window, {width, height}}); });
     glfwSetWindowContentScaleCallback(
         m_window,
         +[](GLFWwindow *window, float xscale, float yscale)
-        { application::get().queue_event(window_content_scale_event{window, {xscale, yscale}}); });
+        { application::get().glfw_event(window_content_scale_event{window, {xscale, yscale}}); });
     glfwSetErrorCallback(
         /* */
         +[](int error_code, char const *description)
-        { application::get().queue_event(error_event{error_code, description}); });
+        { application::get().glfw_event(error_event{error_code, description}); });
     glfwSetMonitorCallback(
         /* */
         +[](GLFWmonitor *monitor, int event)
-        { application::get().queue_event(monitor_event{monitor, event}); });
+        { application::get().glfw_event(monitor_event{monitor, event}); });
     /* TODO: Figure out why this hangs on windows then remove this line */ if (0)
       glfwSetJoystickCallback(
           /* */
           +[](int jid, int event)
-          { application::get().queue_event(joystick_event{jid, event}); });
+          { application::get().glfw_event(joystick_event{jid, event}); });
   }
 }
 engine::application::~application()
 {
-  m_layers_tasks          = {};
+  m_coroutines.clear(); /* tasks may hold layers and gl objects */
+  m_layers_tasks.clear();
   m_layer_update_schedule = {};
   m_layers                = {};
+  m_render_target         = {};
+  m_offscreen_framebuffer = {};
+  m_offscreen_color       = {};
   m_renderer              = {};
   m_window                = (glfwDestroyWindow(m_window), nullptr);
   glfwTerminate();
   runtime_assert(s_instance == this, "application singleton violation");
   s_instance = nullptr;
 }
+auto engine::application::set_viewport_fit(viewport_fit value) -> void
+{
+  m_render_target.set_fit(value);
+  fit_viewport();
+  m_redraw_requested = true;
+}
+auto engine::application::fit_viewport() -> void
+{
+  m_input.viewport        = render_target::fit(m_render_target.get_fit(), m_input.window_size);
+  m_input.cursor_viewport = m_input.to_viewport(m_input.cursor_window);
+}
+auto engine::application::apply_input(event_container_t const &event) -> void
+{
+  using namespace engine::events::glfw;
+  if (auto const *key = std::any_cast<key_event>(&event))
+  {
+    if (0 <= key->key and key->key <= GLFW_KEY_LAST) m_input.keys.set(static_cast<size_t>(key->key), key->action != GLFW_RELEASE);
+    m_input.mods = key->mods;
+  }
+  else if (auto const *button = std::any_cast<mouse_button_event>(&event))
+  {
+    if (0 <= button->button and button->button <= GLFW_MOUSE_BUTTON_LAST) m_input.mouse_buttons.set(static_cast<size_t>(button->button), button->action != GLFW_RELEASE);
+    m_input.mods = button->mods;
+  }
+  else if (auto const *cursor = std::any_cast<cursor_pos_event>(&event))
+  {
+    m_input.cursor_window   = cursor->pos;
+    m_input.cursor_viewport = m_input.to_viewport(m_input.cursor_window);
+  }
+  else if (auto const *size = std::any_cast<window_size_event>(&event))
+  {
+    m_input.window_size = size->size;
+    fit_viewport();
+  }
+  else if (auto const *enter = std::any_cast<cursor_enter_event>(&event)) m_input.cursor_inside = enter->entered;
+  else if (auto const *focus = std::any_cast<window_focus_event>(&event))
+  {
+    m_input.focused = focus->focused;
+    if (not m_input.focused) m_input.keys.reset(), m_input.mouse_buttons.reset(); /* releases go to the focused window */
+  }
+  else if (auto const *framebuffer = std::any_cast<framebuffer_size_event>(&event)) m_input.framebuffer_size = framebuffer->size;
+  else if (auto const *scale = std::any_cast<window_content_scale_event>(&event)) m_input.content_scale = scale->scale;
+}
+template <typename T>
+auto engine::application::glfw_event(T &&event) -> void
+{
+  using namespace engine::events::glfw;
+  if (m_player and not std::same_as<std::remove_cvref_t<T>, error_event>) return; /* the log is the input, errors are still reported */
+  queue_event(std::forward<T>(event));
+  apply_input(m_events.back());
+}
 auto engine::application::schedule_layer_pop(std::shared_ptr<layer_t const> layer) -> void
 {
-  schedule_layer_manipulation(
-      [layer = std::move(layer)](layers_t &layers) mutable
+  m_layers_tasks.emplace_back(
+      [this, layer = std::move(layer)](layers_t &layers) mutable
       {
         auto const it = std::ranges::find(layers, layer);
         runtime_assert(it != layers.end(), "layer {} {} in layer stack", static_cast<void const *>(layer.get()), "not");
+        cancel_layer_update(**it);
         layers.erase(it);
         layer = {}; // layer destruct here
       });
 }
+auto engine::application::has_layer_update(layer_t const &layer) const -> bool
+{
+  return m_layer_update_schedule.is_live(layer.m_update_slot) and m_layer_update_schedule.get(layer.m_update_slot).layer == &layer;
+}
+auto engine::application::schedule_layer_update(layer_t &layer) -> void
+{
+  if (not has_layer_update(layer)) layer.m_update_slot = m_layer_update_schedule.add({&layer});
+  m_layer_update_schedule.schedule(layer.m_update_slot, clock::now());
+}
+auto engine::application::cancel_layer_update(layer_t &layer) -> void
+{
+  if (has_layer_update(layer)) m_layer_update_schedule.remove(layer.m_update_slot);
+  layer.m_update_slot = layer_update_schedule_t::s_npos;
+}
+auto engine::application::reconcile_layer_updates() -> void
+{
+  /* an entry is kept only if a layer still in the stack points back at it, so a new layer reusing a popped one's address is not mistaken for it */
+  auto const owned = [this](scheduled_layer const &scheduled)
+  {
+    auto const it = std::ranges::find(m_layers, scheduled.layer, [](auto const &layer) static { return layer.get(); });
+    return it != m_layers.end() and has_layer_update(**it) and &m_layer_update_schedule.get((*it)->m_update_slot) == &scheduled;
+  };
+  m_layer_update_schedule.remove_if(std::not_fn(owned));
+  for (auto const &layer : m_layers)
+    if (layer and not has_layer_update(*layer)) schedule_layer_update(*layer);
+}
+auto engine::application::get_layer_metrics(layer_t const &layer) -> layer_metrics const &
+{
+  auto const type = std::type_index{typeid(layer)};
+  if (auto const it = m_layer_metrics.find(type); it != m_layer_metrics.end()) return it->second;
+  auto const name = utilities::demangle(type.name());
+  return m_layer_metrics[type] = {
+             .update = &m_metrics.get_histogram(std::format("layer update {}", name)),
+             .render = &m_metrics.get_histogram(std::format("layer render {}", name)),
+         };
+}
 auto engine::application::run() -> int
 {
-  auto const main_loop = [this] -> bool
+  auto &frame_interval = m_metrics.get_histogram("engine frame interval"); /* between consecutive presented frames */
+  auto &render_time    = m_metrics.get_histogram("engine render");
+  auto &posted_depth   = m_metrics.get_gauge("engine posted event depth"); /* before each drain */
+  auto &posted_drops   = m_metrics.get_counter("engine posted event drops");
+  auto &alloc_failures = m_metrics.get_counter("engine allocation free violations");
+  auto  engine_stats   = m_stats.make_table("Engine");
+  auto  alloc_stats    = allocation_tracker::enabled ? m_stats.make_table("Allocations") : utilities::stats_sink::table{};
+  auto  next_publish   = clock::now();
+  auto  last_present   = std::optional<clock::time_point>{};
+  auto const main_loop = [&, this] -> bool
   {
     if (glfwWindowShouldClose(m_window)) return false;
+    if (m_options.max_frames and *m_options.max_frames <= m_frame_count) return false;
+    m_frame_count++;
+    if (m_options.max_ticks and *m_options.max_ticks <= m_tick_count) return false;
+    ENGINE_PROFILE_SCOPE("frame");
     auto const render_dt          = std::chrono::duration_cast<clock::duration>(m_target_render_period);
     auto const render_appointment = std::exchange(m_render_appointment, std::max(m_render_appointment, clock::now()) + render_dt);
-    /* layer tasks   */ if (not m_layers_tasks.empty())
+    /* pending gpu work */ if (true)
+    {
+      ENGINE_PROFILE_SCOPE("pending gpu work");
+      m_renderer.programs.poll();
+      try
+      {
+        m_renderer.capture.poll(m_renderer.state);
+      }
+      catch (std::exception const &e)
+      {
+        std::println(stderr, "Error in {:?}: {}", "Frame capture", e.what()); /* the capture is stopped, the frame goes on */
+      }
+      auto const gpu_frames = profiler::enabled or m_render_target.is_dynamic() ? m_renderer.frame_timer.poll() : std::span<engine::renderer::gpu_timer::sample const>{};
+      m_render_target.update_scale(gpu_frames, m_target_render_period);
+      for (auto const &sample : gpu_frames)
+        profiler::record({.name = "gpu frame", .begin = sample.begin, .end = sample.begin + std::chrono::duration_cast<clock::duration>(sample.elapsed), .where = profiler::track::gpu});
+    }
+    /* file loads    */ m_file_loader.poll();
+    /* stats output  */ if (m_stats.poll(); next_publish <= clock::now())
     {
-      for (auto &task : std::exchange(m_layers_tasks, {}))
+      auto const interval = frame_interval.get_snapshot();
+      auto const ms       = [](utilities::metrics::duration value) static { return 1000.0 * value.count(); };
+      next_publish        = clock::now() + std::chrono::milliseconds{500};
+      engine_stats.publish({
+          {"frame p50  ms", ms(interval.p50)},
+          {"frame p90  ms", ms(interval.p90)},
+          {"frame p99  ms", ms(interval.p99)},
+          {"frame max  ms", ms(interval.max)},
+          {"render p99 ms", ms(render_time.get_snapshot().p99)},
+          {" pacer misses", m_frame_pacer.get_statistics().deadline_misses},
+          {" render scale", m_render_target.get_scale()},
+          {" posted depth", posted_depth.get()},
+          {" posted drops", posted_drops.get()},
+      });
+    }
+    /* frame arena   */ m_frame_arena.begin_frame();
+    /* layer tasks   */ if (auto layers_tasks = std::move(m_layers_tasks); /* moved out storage is in last frame's arena */
+                            utilities::rebind(m_layers_tasks, m_frame_arena.get_resource()), not layers_tasks.empty())
+    {
+      ENGINE_PROFILE_SCOPE("layer tasks");
+      auto const allocation_phase = allocation_tracker::phase_scope{allocation_tracker::phase::layer_tasks};
+      for (auto &task : layers_tasks)
       {
         try
         {
           task(m_layers);
-          if (m_layers.empty()) m_renderer = {}; /* TODO: Reconsider. Could cause issues later on. */
+          m_redraw_requested = true;
+          if (m_layers.empty()) m_renderer.trim(); /* keep warm gl objects for the layers pushed next */
+          m_renderer.state.invalidate();           /* destroyed layers delete their vertex arrays, gl silently rebinds them to 0 */
           runtime_assert(m_layers_tasks.empty(), "{0:?} can not be scheduled from a {0:?} task", "between frame layer manipulation");
         }
         catch (std::exception const &e)
         {
           std::println(stderr, "Error in {:?}: {}", "between frame layer manipulation", e.what());
-          m_layers_tasks = {};
+          m_layers_tasks.clear();
         };
       }
 
       if (auto const nulls = std::ranges::remove(m_layers, nullptr);
           not nulls.empty() /* remove nulls in m_layers */)
         m_layers.erase(nulls.begin(), nulls.end());
-
-      auto appointments = std::unordered_map<layer_t const *, clock::time_point>{};
-      appointments.reserve(m_layer_update_schedule.size());
-      while (not m_layer_update_schedule.empty()) // empty out m_layer_update_schedule
-      {
-        auto const [time, index, layer] = m_layer_update_schedule.top();
-        /*                             */ m_layer_update_schedule.pop();
-        if (layer.expired()) continue;
-        auto const [it, inserted] /* */ = appointments.insert({layer.lock().get(), time});
-        runtime_assert(inserted, "layer {} was found twice in the update schedule", static_cast<void *>(layer.lock().get()));
-        (void)index, (void)it;           // unused
-      }
-      for (auto const &layer : m_layers) // populate m_layer_update_schedule
-      {
-        auto const index       = static_cast<size_t>(&layer - m_layers.data());
-        auto const appointment = appointments.contains(layer.get()) ? appointments.at(layer.get()) : clock::now();
-        m_layer_update_schedule.push({appointment, index, layer});
-      }
     }
     /* events        */ if (true)
     {
+      ENGINE_PROFILE_SCOPE("events");
+      auto const allocation_phase = allocation_tracker::phase_scope{allocation_tracker::phase::events};
       glfwPollEvents();
-      std::swap(m_events, m_events_swap);
-      m_events.reserve(m_events_swap.capacity());
-      for (auto const &event : m_events_swap)
+      if (m_player)
+        while (auto event = m_player->next(m_frame_count, m_tick_count))
+        {
+          m_events.push_back(std::move(*event));
+          apply_input(m_events.back());
+        }
+      posted_depth.set(static_cast<double>(m_posted_events.get_depth()));
+      posted_drops.add(m_posted_events.get_dropped() - posted_drops.get());
+      for ([[maybe_unused]] auto const _ : std::views::iota(0zu, m_posted_events.get_capacity())) /* bounded, producers can not starve the frame */
+      {
+        auto event = m_posted_events.try_pop();
+        if (not event) break;
+        m_events.push_back(std::move(*event));
+      }
+      auto const events = std::move(m_events); /* moved out storage is in last frame's arena */
+      utilities::rebind(m_events, m_frame_arena.get_resource());
+      if (not events.empty()) m_redraw_requested = true;
+      if (m_recorder)
+        for (auto const &event : events) m_recorder->write(m_frame_count, m_tick_count, event);
+      for (auto const &event : events)
       {
         for (auto const &layer : m_layers)
         {
           try
           {
-            layer->on_event(event);
+            auto      &l                = *layer;
+            auto const allocation_layer = allocation_tracker::layer_scope{typeid(l).name()};
+            l.on_event(event);
           }
           catch (std::exception const &e)
           {
@@ -211,54 +524,158 @@ auto engine::application::run() -> int
           }
         }
       }
-      m_events_swap.clear();
     }
-    /* update layers */ while (not m_layer_update_schedule.empty())
+    /* coroutines    */ if (true)
+    {
+      ENGINE_PROFILE_SCOPE("coroutines");
+      auto const allocation_phase = allocation_tracker::phase_scope{allocation_tracker::phase::update};
+      m_coroutines.resume_due();
+    }
+    /* update layers */ while (clock::now() <= render_appointment)
     {
-      auto const [appointment, index, layer] = m_layer_update_schedule.top();
-      if (render_appointment < appointment or
-          render_appointment < clock::now()) break;
-      m_layer_update_schedule.pop();
-      if (layer.expired()) continue;
-      std::this_thread::sleep_until(appointment);
+      if (auto const next_tick = m_player ? m_player->get_next_tick() : std::nullopt;
+          next_tick and *next_tick <= m_tick_count) break; /* the next replayed event is dispatched first */
+      if (m_options.max_ticks and *m_options.max_ticks <= m_tick_count) break;
+      auto const due = m_layer_update_schedule.pop(render_appointment);
+      if (not due) break;
+      {
+        ENGINE_PROFILE_SCOPE("wait for update");
+        m_frame_pacer.wait_until(due->deadline);
+      }
       try
       {
-        auto const update_delay          = layer.lock()->on_update();
+        auto &layer = *m_layer_update_schedule.get(due->slot).layer; /* alive, it is in m_layers */
+        auto const &metrics = get_layer_metrics(layer);
+        ENGINE_PROFILE_SCOPE("on_update", typeid(layer).name());
+        auto const allocation_phase = allocation_tracker::phase_scope{allocation_tracker::phase::update};
+        auto const allocation_layer = allocation_tracker::layer_scope{typeid(layer).name()};
+        m_tick_count++;
+        auto const update_start = clock::now();
+        auto const update_delay = layer.on_update();
+        metrics.update->record(clock::now() - update_start);
+        if (update_delay >= s_never_update) continue;
         auto const update_delay_duration = std::chrono::duration_cast<clock::duration>(update_delay);
-        auto const next_appointment      = std::max(clock::now(), appointment + update_delay_duration);
-        m_layer_update_schedule.push({next_appointment, index, layer});
+        m_layer_update_schedule.schedule(due->slot, std::max(clock::now(), due->deadline + update_delay_duration));
       }
       catch (std::exception const &e)
       {
         std::println(stderr, "Error in {:?}: {}", "Layer update", e.what());
       }
     }
-    /* render layers */ if (true)
+    /* render layers */ if (m_options.backend != options::backend_t::no_render and
+                            (std::exchange(m_redraw_requested, false) or std::ranges::any_of(m_layers, &layer_t::is_dirty)))
     {
-      /* viewport fit: center zoom to fit */ { /* TODO: this feature is hardcoded consider setting up an enum? */
-        int window_width, window_height;
-        glfwGetWindowSize(m_window, &window_width, &window_height);
-        auto const vmax     = std::max(window_width, window_height);
-        auto const window_x = (window_width - vmax) / 2;
-        auto const window_y = (window_height - vmax) / 2;
-        glViewport(window_x, window_y, vmax, vmax);
+      ENGINE_PROFILE_SCOPE("render");
+      auto const allocation_phase = allocation_tracker::phase_scope{allocation_tracker::phase::render};
+      m_renderer.state.begin_frame();
+      m_render_target.begin(m_renderer, m_input.framebuffer_size);
+      if (m_frame_pacer.get_mode() == frame_pacer::mode::sleep_spin)
+      {
+        ENGINE_PROFILE_SCOPE("wait for render");
+        m_frame_pacer.wait_until(render_appointment);
       }
-      std::this_thread::sleep_until(render_appointment);
+      auto const render_start = clock::now();
+      auto const gpu_timed    = profiler::enabled or m_render_target.is_dynamic();
+      if (gpu_timed) m_renderer.frame_timer.begin();
       for (auto const &layer : get_layers())
       {
         try /* TODO: consider enforcing `layer::render` to be `noexcept` */
         {
-          layer->on_render();
+          auto &l = *layer;
+          ENGINE_PROFILE_SCOPE("on_render", typeid(l).name());
+          auto const allocation_layer = allocation_tracker::layer_scope{typeid(l).name()};
+          auto const layer_start      = clock::now();
+          l.on_render();
+          m_renderer.sprites.flush(m_renderer);
+          get_layer_metrics(l).render->record(clock::now() - layer_start);
         }
         catch (std::exception const &e)
         {
           std::println(stderr, "Error in {:?}: {}", "Layer render", e.what());
+          m_renderer.sprites.discard(); /* a half rendered layer's sprites would land in the next layer's group */
         }
+        m_renderer.commands.barrier(); /* layers and the sprites they flushed stay in stack order, packets are only sorted within a layer */
+      }
+      try
+      {
+        ENGINE_PROFILE_SCOPE("submit");
+        m_renderer.commands.submit(m_renderer.state);
       }
-      glfwSwapBuffers(m_window);
+      catch (std::exception const &e)
+      {
+        std::println(stderr, "Error in {:?}: {}", "Command list submit", e.what());
+      }
+      m_renderer.sprites.end_frame(m_renderer);
+      m_render_target.end(m_renderer);
+      if (gpu_timed) m_renderer.frame_timer.end();
+      m_renderer.capture.read(m_renderer, m_input.framebuffer_size);
+      render_time.record(clock::now() - render_start);
+      ENGINE_PROFILE_SCOPE("swap");
+      if (m_options.backend == options::backend_t::window) glfwSwapBuffers(m_window);
+      else glFinish(); /* no swap to throttle on, keep offscreen frames from queueing up */
+      auto const present = clock::now();
+      if (last_present) frame_interval.record(present - *last_present);
+      last_present = present;
+    }
+    /* idle          */ else
+    {
+      ENGINE_PROFILE_SCOPE("idle");
+      last_present = {}; /* skipped frames are not slow frames */
+#if /* */ not defined(__EMSCRIPTEN__) /* the browser can not block, skipping the frame is enough */
+      auto const next_update = std::min(m_layer_update_schedule.next_deadline().value_or(clock::time_point::max()),
+                                        m_coroutines.next_deadline().value_or(clock::time_point::max()));
+      auto const timeout     = m_player and not m_player->is_done() ? 0.0 /* replayed events do not wake the loop */
+                                                                        : std::clamp(std::chrono::duration<double>{next_update - clock::now()}.count(), 0.0, 1.0);
+      glfwWaitEventsTimeout(timeout); /* queued events are dispatched next frame */
+#endif // not defined(__EMSCRIPTEN__)
+    }
+    /* gl errors     */ try
+    {
+      utilities::gl::check_frame(); /* errors left behind by `glCheckError` breadcrumbs or reported by debug output */
+    }
+    catch (std::exception const &e)
+    {
+      std::println(stderr, "Error in {:?}: {}", "GL frame check", e.what());
+    }
+    /* allocations   */ if constexpr (allocation_tracker::enabled)
+    {
+      auto const &report = m_allocation_report = allocation_tracker::end_frame();
+      using enum allocation_tracker::phase;
+      for (auto const [i, violation] : std::views::enumerate(report.violations))
+        if (violation and m_frame_count > s_allocation_warmup_frames)
+        {
+          alloc_failures.add();
+          std::println(stderr, "Error in {:?}: phase {:?} allocated {} times in frame {}", "Allocation free phase",
+                       allocation_tracker::s_phase_names.at(static_cast<size_t>(i)), report.phases.at(static_cast<size_t>(i)).allocations, m_frame_count);
+        }
+      alloc_stats.publish({
+          {"  layer tasks", report.phases[std::to_underlying(layer_tasks)].allocations},
+          {"       events", report.phases[std::to_underlying(events)].allocations},
+          {"       update", report.phases[std::to_underlying(update)].allocations},
+          {"       render", report.phases[std::to_underlying(render)].allocations},
+          {"        other", report.phases[std::to_underlying(other)].allocations},
+          {" update bytes", report.phases[std::to_underlying(update)].bytes},
+          {" render bytes", report.phases[std::to_underlying(render)].bytes},
+          {"   violations", alloc_failures.get()},
+      });
     }
     return true;
   };
   RUN_MAIN_LOOP(main_loop); /* equivalent to `while (main_loop());` */
+  if (m_player and not m_player->is_done())
+    std::println(stderr, "Error in {:?}: run ended after {} of the logged events", "Event replay", m_player->get_count());
+  if (m_player and m_player->get_late_frames())
+    std::println(stderr, "Event replay: {} events dispatched on a later frame than recorded", m_player->get_late_frames());
+  if (m_recorder) m_recorder->flush();
+  if (not m_options.trace_path.empty() and not profiler::write_chrome_trace(m_options.trace_path))
+    std::println(stderr, "Error in {:?}: {}", "Trace export", profiler::enabled ? "could not write the trace file" : "engine built without ENGINE_ENABLE_PROFILER");
+  try
+  {
+    m_renderer.capture.stop(m_renderer.state); /* the last readbacks and the encoder queue */
+  }
+  catch (std::exception const &e)
+  {
+    std::println(stderr, "Error in {:?}: {}", "Frame capture", e.what());
+  }
   return EXIT_SUCCESS;
 }
\ No newline at end of file
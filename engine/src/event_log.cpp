@@ -0,0 +1,224 @@
+#include <engine/event_log.hpp>
+#include <engine/events.hpp>
+
+namespace
+{
+  using namespace engine::events::glfw;
+
+  /* Index in this list is the type tag on disk, append only. Monitors are host state and not replayed. */
+  using logged_events_t = std::tuple<key_event, char_event, drop_event, scroll_event, char_mods_event, cursor_pos_event, window_pos_event,
+                                     window_size_event, cursor_enter_event, window_close_event, mouse_button_event, window_focus_event,
+                                     window_iconify_event, window_refresh_event, window_maximize_event, framebuffer_size_event,
+                                     window_content_scale_event, error_event, joystick_event>;
+
+  /* Everything but the window, which is the running one on replay. */
+  auto fields(key_event &e) { return std::tie(e.key, e.scancode, e.action, e.mods); }
+  auto fields(char_event &e) { return std::tie(e.codepoint); }
+  auto fields(drop_event &e) { return std::tie(e.paths); }
+  auto fields(scroll_event &e) { return std::tie(e.offset); }
+  auto fields(char_mods_event &e) { return std::tie(e.codepoint, e.mods); }
+  auto fields(cursor_pos_event &e) { return std::tie(e.pos); }
+  auto fields(window_pos_event &e) { return std::tie(e.pos); }
+  auto fields(window_size_event &e) { return std::tie(e.size); }
+  auto fields(cursor_enter_event &e) { return std::tie(e.entered); }
+  auto fields(window_close_event &) { return std::tie(); }
+  auto fields(mouse_button_event &e) { return std::tie(e.button, e.action, e.mods); }
+  auto fields(window_focus_event &e) { return std::tie(e.focused); }
+  auto fields(window_iconify_event &e) { return std::tie(e.iconified); }
+  auto fields(window_refresh_event &) { return std::tie(); }
+  auto fields(window_maximize_event &e) { return std::tie(e.maximized); }
+  auto fields(framebuffer_size_event &e) { return std::tie(e.size); }
+  auto fields(window_content_scale_event &e) { return std::tie(e.scale); }
+  auto fields(error_event &e) { return std::tie(e.error_code, e.description); }
+  auto fields(joystick_event &e) { return std::tie(e.jid, e.event); }
+
+  template <typename T>
+  concept has_window = requires(T &event) { { event.window } -> std::same_as<GLFWwindow *&>; };
+
+  auto write_varint(std::vector<uint8_t> &out, uint64_t value) -> void
+  {
+    for (; value >= 0x80u; value >>= 7u) out.push_back(static_cast<uint8_t>(value | 0x80u));
+    out.push_back(static_cast<uint8_t>(value));
+  }
+  auto write_raw(std::vector<uint8_t> &out, auto value) -> void
+  {
+    auto const bytes = std::bit_cast<std::array<uint8_t, sizeof(value)>>(value);
+    out.insert(out.end(), bytes.begin(), bytes.end());
+  }
+  template <typename T>
+  auto write_field(std::vector<uint8_t> &out, T const &value) -> void
+  {
+    if constexpr /**/ (std::same_as<T, bool>) out.push_back(value ? 1u : 0u);
+    else if constexpr (std::signed_integral<T>) write_varint(out, (static_cast<uint64_t>(value) << 1u) ^ static_cast<uint64_t>(int64_t{value} >> 63)); /* zigzag */
+    else if constexpr (std::unsigned_integral<T>) write_varint(out, value);
+    else if constexpr (std::floating_point<T>) write_raw(out, value);
+    else if constexpr (std::same_as<T, std::string>)
+    {
+      write_varint(out, value.size());
+      out.insert(out.end(), value.begin(), value.end());
+    }
+    else if constexpr (std::same_as<T, std::filesystem::path>) write_field(out, value.generic_string());
+    else if constexpr (requires { value.length(); value[0]; }) /* glm vectors */
+      for (auto i = 0; i < value.length(); ++i) write_field(out, value[i]);
+    else /*                                   */ /* vectors */
+    {
+      write_varint(out, value.size());
+      for (auto const &element : value) write_field(out, element);
+    }
+  }
+
+  struct reader
+  {
+      std::span<std::byte const> bytes;
+      size_t &offset;
+
+      auto byte() -> uint8_t
+      {
+        engine::runtime_assert(offset < bytes.size(), "Truncated event log at byte {}", offset);
+        return std::to_integer<uint8_t>(bytes[offset++]);
+      }
+      auto varint() -> uint64_t
+      {
+        auto value = uint64_t{0u};
+        for (auto shift = 0u;; shift += 7u)
+        {
+          auto const next = byte();
+          engine::runtime_assert(shift < 64u, "Malformed varint in event log at byte {}", offset);
+          value |= uint64_t{next & 0x7Fu} << shift;
+          if (not(next & 0x80u)) return value;
+        }
+      }
+      template <typename T>
+      auto raw() -> T
+      {
+        auto bytes_value = std::array<uint8_t, sizeof(T)>{};
+        for (auto &b : bytes_value) b = byte();
+        return std::bit_cast<T>(bytes_value);
+      }
+      template <typename T>
+      auto field(T &value) -> void
+      {
+        if constexpr /**/ (std::same_as<T, bool>) value = byte() != 0u;
+        else if constexpr (std::signed_integral<T>)
+        {
+          auto const encoded = varint();
+          value              = static_cast<T>(static_cast<int64_t>(encoded >> 1u) ^ -static_cast<int64_t>(encoded & 1u));
+        }
+        else if constexpr (std::unsigned_integral<T>) value = static_cast<T>(varint());
+        else if constexpr (std::floating_point<T>) value = raw<T>();
+        else if constexpr (std::same_as<T, std::string>)
+        {
+          auto const size = varint();
+          engine::runtime_assert(size <= bytes.size() - offset, "Truncated event log at byte {}", offset);
+          value.assign(reinterpret_cast<char const *>(bytes.data() + offset), size);
+          offset += size;
+        }
+        else if constexpr (std::same_as<T, std::filesystem::path>)
+        {
+          auto string = std::string{};
+          field(string);
+          value = std::move(string);
+        }
+        else if constexpr (requires { value.length(); value[0]; })
+          for (auto i = 0; i < value.length(); ++i) field(value[i]);
+        else
+        {
+          value.resize(varint());
+          for (auto &element : value) field(element);
+        }
+      }
+  };
+} // namespace
+
+engine::event_log::recorder::recorder(std::filesystem::path const &file_path, uint64_t seed)
+{
+  m_buffer.reserve(2zu * s_flush_size); /* recording stays out of the allocation free event phase */
+  m_file.open(file_path, std::ios::binary | std::ios::trunc);
+  runtime_assert(m_file.is_open(), "Failed to open event log {} for writing", file_path.string());
+  m_buffer.insert(m_buffer.end(), s_magic.begin(), s_magic.end());
+  write_varint(m_buffer, s_version);
+  write_raw(m_buffer, seed);
+  flush();
+}
+engine::event_log::recorder::~recorder()
+{
+  flush();
+}
+auto engine::event_log::recorder::write(uint64_t frame, uint64_t tick, std::any const &event) -> bool
+{
+  auto const encode = [&]<size_t... is>(std::index_sequence<is...>)
+  {
+    return ([&]<size_t i>(std::integral_constant<size_t, i>)
+            {
+              using event_t = std::tuple_element_t<i, logged_events_t>;
+              auto const *value = std::any_cast<event_t>(&event);
+              if (not value) return false;
+              write_varint(m_buffer, frame - m_frame);
+              write_varint(m_buffer, tick - m_tick);
+              m_buffer.push_back(static_cast<uint8_t>(i));
+              std::apply([&](auto const &...field) { (write_field(m_buffer, field), ...); }, fields(const_cast<event_t &>(*value))); /* only read */
+              return true;
+            }(std::integral_constant<size_t, is>{}) or ...);
+  };
+  if (not encode(std::make_index_sequence<std::tuple_size_v<logged_events_t>>{})) return false;
+  m_frame = frame, m_tick = tick, ++m_count;
+  if (m_buffer.size() >= s_flush_size) flush();
+  return true;
+}
+auto engine::event_log::recorder::flush() -> void
+{
+  if (m_buffer.empty()) return;
+  m_file.write(reinterpret_cast<char const *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+  m_file.flush();
+  m_buffer.clear();
+}
+
+engine::event_log::player::player(std::filesystem::path const &file_path, GLFWwindow *window)
+  : m_window{window}
+{
+  m_file = *runtime_assert(utilities::mapped_file::open(file_path), "Failed to open event log {}", file_path.string());
+  auto const bytes = m_file.bytes();
+  runtime_assert(bytes.size() >= s_magic.size() and std::ranges::equal(bytes.first(s_magic.size()), s_magic, {}, {}, [](char c) { return std::byte(c); }),
+                 "{} is not an event log", file_path.string());
+  m_offset           = s_magic.size();
+  auto in            = reader{bytes, m_offset};
+  auto const version = in.varint();
+  runtime_assert(version == s_version, "Event log {} has version {}, expected {}", file_path.string(), version, s_version);
+  m_seed = in.raw<uint64_t>();
+}
+auto engine::event_log::player::get_next_tick() -> std::optional<uint64_t>
+{
+  if (is_done()) return std::nullopt;
+  if (not std::exchange(m_peeked, true))
+  {
+    auto in = reader{m_file.bytes(), m_offset};
+    m_frame += in.varint();
+    m_tick += in.varint();
+  }
+  return m_tick;
+}
+auto engine::event_log::player::next(uint64_t frame, uint64_t tick) -> std::optional<std::any>
+{
+  if (auto const next_tick = get_next_tick(); not next_tick or *next_tick > tick or m_frame > frame) return std::nullopt;
+  if (m_frame != frame) ++m_late_frames;
+  m_peeked = false;
+  ++m_count;
+
+  auto in         = reader{m_file.bytes(), m_offset};
+  auto const type = size_t{in.byte()};
+  auto result     = std::optional<std::any>{};
+  [&]<size_t... is>(std::index_sequence<is...>)
+  {
+    ((is == type ? void(result = [&]
+                        {
+                          auto event = std::tuple_element_t<is, logged_events_t>{};
+                          if constexpr (has_window<decltype(event)>) event.window = m_window;
+                          std::apply([&](auto &...field) { (in.field(field), ...); }, fields(event));
+                          return std::any{std::move(event)};
+                        }())
+                 : void()),
+     ...);
+  }(std::make_index_sequence<std::tuple_size_v<logged_events_t>>{});
+  runtime_assert(result.has_value(), "Unknown event type {} in event log at byte {}", type, m_offset);
+  return result;
+}
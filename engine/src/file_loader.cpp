@@ -0,0 +1,68 @@
+#include <engine/file_loader.hpp>
+
+engine::utilities::file_loader::file_loader()
+{
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_thread = std::jthread{[this](std::stop_token stop)
+                          {
+                            auto lock = std::unique_lock{m_mutex};
+                            while (true)
+                            {
+                              m_wake.wait(lock, stop, [this] { return not m_requests.empty(); });
+                              if (m_requests.empty()) break; /* stopped, and everything queued before is loaded */
+                              auto next = std::move(m_requests.front());
+                              m_requests.pop_front();
+                              lock.unlock();
+                              complete(next);
+                              lock.lock();
+                            }
+                          }};
+#endif // not defined(__EMSCRIPTEN__)
+}
+engine::utilities::file_loader::~file_loader()
+{
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_thread = {};
+#endif // not defined(__EMSCRIPTEN__)
+  poll();
+}
+auto engine::utilities::file_loader::load(std::filesystem::path file_path) -> std::future<result_t>
+{
+  auto request_value = request{.file_path = std::move(file_path)};
+  auto future        = request_value.promise.get_future();
+  {
+    auto lock = std::scoped_lock{m_mutex};
+    m_requests.push_back(std::move(request_value));
+  }
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_wake.notify_one();
+#endif // not defined(__EMSCRIPTEN__)
+  return future;
+}
+auto engine::utilities::file_loader::poll() -> void
+{
+#if /* */ defined(__EMSCRIPTEN__)
+  auto requests = std::deque<request>{};
+  {
+    auto lock = std::scoped_lock{m_mutex};
+    requests.swap(m_requests);
+  }
+  for (auto &request : requests) complete(request);
+#endif // defined(__EMSCRIPTEN__)
+}
+auto engine::utilities::file_loader::get_pending() -> size_t
+{
+  auto lock = std::scoped_lock{m_mutex};
+  return m_requests.size();
+}
+auto engine::utilities::file_loader::complete(request &request) -> void
+{
+  try
+  {
+    request.promise.set_value(mapped_file::open(request.file_path));
+  }
+  catch (...)
+  {
+    request.promise.set_exception(std::current_exception());
+  }
+}
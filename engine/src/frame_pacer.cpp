@@ -0,0 +1,27 @@
+#include <engine/frame_pacer.hpp>
+
+auto engine::frame_pacer::histogram::record(duration value) noexcept -> void
+{
+  auto const micros = static_cast<uint64_t>(std::max(0.0, value.count() * 1e6));
+  auto const bucket = std::min<size_t>(std::bit_width(micros), s_bucket_count - 1zu);
+  buckets[bucket]++;
+  count++;
+  max = std::max(max, value);
+}
+auto engine::frame_pacer::wait_until(clock::time_point deadline) -> void
+{
+  auto const sleep_target = deadline - std::chrono::duration_cast<clock::duration>(m_margin);
+  if (clock::now() < sleep_target)
+  {
+    std::this_thread::sleep_until(sleep_target);
+    auto const overshoot = duration{clock::now() - sleep_target};
+    m_statistics.overshoot.record(overshoot);
+    /* jump up to a worse overshoot right away, decay slowly back towards tighter margins */
+    m_margin = std::clamp(std::max(overshoot * 1.25, m_margin * 0.99), s_min_margin, s_max_margin);
+  }
+  while (clock::now() < deadline) std::this_thread::yield();
+  auto const late = duration{clock::now() - deadline};
+  m_statistics.jitter.record(late);
+  m_statistics.waits++;
+  if (late > s_miss_threshold) m_statistics.deadline_misses++;
+}
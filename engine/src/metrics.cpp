@@ -0,0 +1,89 @@
+#include <engine/metrics.hpp>
+
+namespace
+{
+  using engine::utilities::metrics;
+  auto slice_index(metrics::clock::time_point time) noexcept -> int64_t
+  {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count() / metrics::histogram::s_slice_period.count();
+  }
+  template <typename T>
+  auto get_or_insert(std::map<std::string, std::unique_ptr<T>, std::less<>> &map, std::string_view name) -> T &
+  {
+    if (auto const it = map.find(name); it != map.end()) return *it->second;
+    return *map.emplace(std::string{name}, std::make_unique<T>()).first->second;
+  }
+} // namespace
+
+auto engine::utilities::metrics::histogram::record(duration value) noexcept -> void
+{
+  auto const nanoseconds = static_cast<uint64_t>(std::max(0.0, value.count() * 1e9));
+  auto const index       = slice_index(clock::now());
+  auto      &slice       = m_slices[static_cast<size_t>(index) % s_slice_count];
+  if (auto epoch = slice.epoch.load(std::memory_order_acquire); epoch != index)
+  {
+    /* the first recorder of a new period recycles the slice, concurrent records at the boundary may be lost */
+    if (epoch < index and slice.epoch.compare_exchange_strong(epoch, index, std::memory_order_acq_rel))
+    {
+      for (auto &count : slice.counts) count.store(0u, std::memory_order_relaxed);
+      slice.max.store(0u, std::memory_order_relaxed);
+    }
+  }
+  slice.counts[bucket_of(nanoseconds)].fetch_add(1u, std::memory_order_relaxed);
+  for (auto max = slice.max.load(std::memory_order_relaxed);
+       max < nanoseconds and not slice.max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed);) {}
+}
+auto engine::utilities::metrics::histogram::get_snapshot() const noexcept -> snapshot
+{
+  auto const now    = slice_index(clock::now());
+  auto       counts = std::array<uint64_t, s_bucket_count>{};
+  auto       result = snapshot{};
+  auto       max    = uint64_t{};
+  for (auto const &slice : m_slices)
+  {
+    auto const epoch = slice.epoch.load(std::memory_order_acquire);
+    if (epoch < 0 or now - epoch >= static_cast<int64_t>(s_slice_count)) continue;
+    for (auto const &[total, count] : std::views::zip(counts, slice.counts))
+      total += count.load(std::memory_order_relaxed);
+    max = std::max(max, slice.max.load(std::memory_order_relaxed));
+  }
+  result.count = std::ranges::fold_left(counts, uint64_t{}, std::plus{});
+  if (result.count == 0u) return result;
+  auto const percentile = [&counts, total = result.count](double fraction)
+  {
+    auto const rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+    auto       seen = uint64_t{};
+    for (auto const [bucket, count] : std::views::enumerate(counts))
+      if ((seen += count) >= rank) return duration{std::chrono::nanoseconds{bucket_upper_bound(static_cast<size_t>(bucket))}};
+    return duration{std::chrono::nanoseconds{bucket_upper_bound(s_bucket_count - 1zu)}};
+  };
+  result.p50 = std::min(percentile(0.50), duration{std::chrono::nanoseconds{max}});
+  result.p90 = std::min(percentile(0.90), duration{std::chrono::nanoseconds{max}});
+  result.p99 = std::min(percentile(0.99), duration{std::chrono::nanoseconds{max}});
+  result.max = std::chrono::nanoseconds{max};
+  return result;
+}
+auto engine::utilities::metrics::get_counter(std::string_view name) -> counter &
+{
+  auto lock = std::scoped_lock{m_mutex};
+  return get_or_insert(m_counters, name);
+}
+auto engine::utilities::metrics::get_gauge(std::string_view name) -> gauge &
+{
+  auto lock = std::scoped_lock{m_mutex};
+  return get_or_insert(m_gauges, name);
+}
+auto engine::utilities::metrics::get_histogram(std::string_view name) -> histogram &
+{
+  auto lock = std::scoped_lock{m_mutex};
+  return get_or_insert(m_histograms, name);
+}
+auto engine::utilities::metrics::get_report() const -> report
+{
+  auto lock   = std::scoped_lock{m_mutex};
+  auto result = report{};
+  for (auto const &[name, value] : m_counters) /*   */ result.counters.emplace_back(name, value->get());
+  for (auto const &[name, value] : m_gauges) /*     */ result.gauges.emplace_back(name, value->get());
+  for (auto const &[name, value] : m_histograms) /* */ result.histograms.emplace_back(name, value->get_snapshot());
+  return result;
+}
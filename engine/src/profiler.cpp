@@ -0,0 +1,89 @@
+#include <engine/profiler.hpp>
+#include <engine/utilities.hpp>
+
+#if /* */ defined(ENGINE_PROFILER)
+
+namespace
+{
+  using namespace engine::profiler;
+  auto inline constexpr s_ring_capacity = 1zu << 14zu;
+  struct ring
+  {
+      std::array<zone, s_ring_capacity> zones        = {};
+      std::atomic<uint64_t> /*       */ head         = 0u; /* zones ever recorded, the writer is the owning thread only */
+      uint32_t /*                    */ thread_index = 0u;
+  };
+  struct registry
+  {
+      std::mutex /*                   */ mutex = {};
+      std::vector<std::shared_ptr<ring>> rings = {}; /* shared so zones of exited threads survive until export */
+      clock::time_point /*            */ epoch = clock::now();
+  };
+  auto get_registry() -> registry &
+  {
+    auto static instance = registry{};
+    return instance;
+  }
+  auto get_ring() -> ring &
+  {
+    auto thread_local const instance = []
+    {
+      auto &registry = get_registry();
+      auto  lock     = std::scoped_lock{registry.mutex};
+      auto  result   = std::make_shared<ring>();
+      result->thread_index = static_cast<uint32_t>(registry.rings.size()) + 1u;
+      registry.rings.push_back(result);
+      return result;
+    }();
+    return *instance;
+  }
+} // namespace
+
+auto engine::profiler::record(zone const &value) noexcept -> void
+{
+  auto &ring = get_ring();
+  auto const head = ring.head.load(std::memory_order_relaxed);
+  ring.zones[head % s_ring_capacity] = value;
+  ring.head.store(head + 1u, std::memory_order_release);
+}
+auto engine::profiler::write_chrome_trace(std::filesystem::path const &path) -> bool
+{
+  auto &registry = get_registry();
+  auto  rings    = std::vector<std::shared_ptr<ring>>{};
+  {
+    auto lock = std::scoped_lock{registry.mutex};
+    rings     = registry.rings;
+  }
+  auto file = std::ofstream{path};
+  if (not file) return false;
+  auto const micros = [&registry](clock::time_point time)
+  { return std::chrono::duration<double, std::micro>{time - registry.epoch}.count(); };
+  auto separator = "";
+  std::print(file, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  std::print(file, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{{\"name\":\"gpu\"}}}}", std::exchange(separator, ","));
+  auto zones = std::vector<zone>{};
+  for (auto const &ring : rings)
+  {
+    std::print(file, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"thread {}\"}}}}", std::exchange(separator, ","), ring->thread_index, ring->thread_index);
+    /* copy then drop whatever the owning thread overwrote while copying */
+    auto const head_before = ring->head.load(std::memory_order_acquire);
+    auto const first       = head_before > s_ring_capacity ? head_before - s_ring_capacity : 0u;
+    zones.clear();
+    for (auto const i : std::views::iota(first, head_before)) zones.push_back(ring->zones[i % s_ring_capacity]);
+    auto const head_after = ring->head.load(std::memory_order_acquire);
+    auto const overwritten = std::min<size_t>(zones.size(), head_after > first + s_ring_capacity ? head_after - first - s_ring_capacity : 0u);
+    for (auto const &zone : zones | std::views::drop(overwritten))
+    {
+      if (not zone.name) continue;
+      auto const tid = zone.where == track::gpu ? 0u : ring->thread_index;
+      std::print(file, "{}{{\"name\":{:?},\"cat\":{:?},\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}",
+                 std::exchange(separator, ","), zone.name, zone.where == track::gpu ? "gpu" : "cpu", micros(zone.begin), micros(zone.end) - micros(zone.begin), tid);
+      if (zone.detail) std::print(file, ",\"args\":{{\"detail\":{:?}}}", engine::utilities::demangle(zone.detail));
+      std::print(file, "}}");
+    }
+  }
+  std::print(file, "]}}\n");
+  return static_cast<bool>(file);
+}
+
+#endif // defined(ENGINE_PROFILER)
@@ -0,0 +1,85 @@
+#include <engine/render_target.hpp>
+
+auto engine::render_target::fit(viewport_fit mode, glm::ivec2 size) noexcept -> glm::ivec4
+{
+  switch (mode)
+  {
+    case viewport_fit::cover:
+    case viewport_fit::contain:
+    {
+      auto const side = mode == viewport_fit::cover ? std::max(size.x, size.y) : std::min(size.x, size.y);
+      return {(size.x - side) / 2, (size.y - side) / 2, side, side};
+    }
+    case viewport_fit::stretch: return {0, 0, size.x, size.y};
+  }
+  return {0, 0, size.x, size.y};
+}
+auto engine::render_target::update_scale(std::span<renderer::gpu_timer::sample const> samples, duration render_period) -> void
+{
+  if (not is_dynamic()) return void(m_scale = 1.0);
+  auto const budget = render_period * s_budget_share;
+  for (auto const &sample : samples)
+  {
+    auto const load = sample.elapsed / budget;
+    if (load > 1.0) /* fill cost goes with the pixel count, drop straight to the scale that fits */
+      m_scale = std::floor(m_scale / std::sqrt(load) / s_scale_step) * s_scale_step;
+    else if (load < s_raise_share) /* climb back one step at a time */
+      m_scale = m_scale + s_scale_step;
+    m_scale = std::clamp(m_scale, m_min_scale, 1.0);
+  }
+}
+auto engine::render_target::begin(renderer &renderer, glm::ivec2 framebuffer_size) -> void
+{
+  runtime_assert(not m_offscreen, "{} begin without an end", "render target");
+  m_viewport = fit(m_fit, framebuffer_size);
+  if (m_scale >= 1.0 or m_viewport.z <= 0 or m_viewport.w <= 0) /* full resolution draws straight to the destination */
+  {
+    renderer.state.bind_framebuffer(GL_FRAMEBUFFER, 0u);
+    glViewport(m_viewport.x, m_viewport.y, m_viewport.z, m_viewport.w);
+    return;
+  }
+  auto const size = glm::max(glm::ivec2{glm::round(glm::dvec2{m_viewport.z, m_viewport.w} * m_scale)}, glm::ivec2{1});
+  if (not m_framebuffer or size != m_size)
+  {
+    if (not m_framebuffer)
+      m_framebuffer = renderer.framebuffers.make_unique(),
+      m_color       = renderer.renderbuffers.make_unique();
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color.get());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+    renderer.state.bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer.get());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color.get());
+    runtime_assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "{} init fail", "render target");
+    glCheckError();
+    m_size = size;
+  }
+  m_offscreen   = true;
+  m_destination = renderer.state.get_default_framebuffer();
+  renderer.state.set_default_framebuffer(m_framebuffer.get()); /* layers binding framebuffer 0 land here */
+  renderer.state.bind_framebuffer(GL_FRAMEBUFFER, 0u);
+  glViewport(0, 0, m_size.x, m_size.y);
+}
+auto engine::render_target::end(renderer &renderer) -> void
+{
+  if (not std::exchange(m_offscreen, false)) return;
+  renderer.state.set_default_framebuffer(m_destination);
+  renderer.state.bind_framebuffer(GL_READ_FRAMEBUFFER, m_framebuffer.get());
+  renderer.state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0u);
+  glViewport(m_viewport.x, m_viewport.y, m_viewport.z, m_viewport.w);
+  if (m_fit == viewport_fit::contain) /* letterbox bars are outside of the blit */
+  {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+  glBlitFramebuffer(0, 0, m_size.x, m_size.y,
+                    m_viewport.x, m_viewport.y, m_viewport.x + m_viewport.z, m_viewport.y + m_viewport.w,
+                    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  renderer.state.bind_framebuffer(GL_FRAMEBUFFER, 0u);
+  glCheckError();
+}
+auto engine::render_target::reset() -> void
+{
+  runtime_assert(not m_offscreen, "{} reset inside a frame", "render target");
+  m_framebuffer = {};
+  m_color       = {};
+  m_size        = {};
+}
@@ -1,41 +1,706 @@
 #include <engine/renderer.hpp>
 
-auto engine::renderer::handle_cache::set_capacity(size_t capacity) -> void
+#include <condition_variable>
+#include <deque>
+
+namespace
 {
-  if (m_capacity == capacity) return;
-  runtime_assert(capacity <= std::numeric_limits<decltype(m_capacity)>::max(), "max possible capacity exceeded");
-  runtime_assert(capacity >= m_size, "set_capacity({}) would delete {} active handles", capacity, static_cast<decltype(capacity)>(m_size) - capacity);
-  runtime_assert(m_allocator, "null {} access", "allocator");
-  auto const old         = all();
-  auto const old_handles = std::move(m_handles);
-  m_handles              = capacity ? std::make_unique<uint32_t[]>(capacity) : nullptr;
-  m_capacity             = static_cast<decltype(m_capacity)>(capacity);
-  std::ranges::copy(old.subspan(0, std::min(capacity, old.size())), m_handles.get());
-  /**/ if (capacity < old.size())
-    m_allocator->delete_handles(old.subspan(capacity));
-  else if (capacity > old.size())
-    m_allocator->create_handles(all().subspan(old.size()));
+  auto constexpr s_debug_output_khr             = GLenum{0x92'E0}; /* KHR_debug */
+  auto constexpr s_debug_output_synchronous_khr = GLenum{0x82'42};
+  auto constexpr s_debug_type_error_khr         = GLenum{0x82'4C};
+  auto constexpr s_max_reported                 = 16zu; /* kept until thrown, later ones are dropped */
+#if /* */ defined(_WIN32) or defined(_WIN64)
+  using debug_callback_t         = void(APIENTRY *)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const *message, void const *user);
+  using debug_message_callback_t = void(APIENTRY *)(debug_callback_t callback, void const *user);
+  using debug_message_control_t  = void(APIENTRY *)(GLenum source, GLenum type, GLenum severity, GLsizei count, GLuint const *ids, GLboolean enabled);
+#else  // defined(_WIN32) or defined(_WIN64)
+  using debug_callback_t         = void(GL_APIENTRY *)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const *message, void const *user);
+  using debug_message_callback_t = void(GL_APIENTRY *)(debug_callback_t callback, void const *user);
+  using debug_message_control_t  = void(GL_APIENTRY *)(GLenum source, GLenum type, GLenum severity, GLsizei count, GLuint const *ids, GLboolean enabled);
+#endif // defined(_WIN32) or defined(_WIN64)
+} // namespace
+auto engine::utilities::gl::set_check_level(check_level level, void (*(*get_proc_address)(char const *name))()) -> check_level
+{
+  auto &state = s_check_state;
+  state.level = std::min(level, compiled_check_level);
+  auto const load = [get_proc_address]<typename T>(std::type_identity<T>, char const *khr_name, char const *core_name) -> T
+  {
+    auto const proc = get_proc_address(khr_name);
+    return reinterpret_cast<T>(proc ? proc : get_proc_address(core_name));
+  };
+  if (state.level != check_level::off and get_proc_address and renderer::has_extension("GL_KHR_debug"))
+  {
+    auto const message_callback = load(std::type_identity<debug_message_callback_t>{}, "glDebugMessageCallbackKHR", "glDebugMessageCallback");
+    auto const message_control  = load(std::type_identity<debug_message_control_t>{}, "glDebugMessageControlKHR", "glDebugMessageControl");
+    if (message_callback and message_control)
+    {
+      debug_callback_t const callback = [](GLenum, GLenum, GLuint, GLenum, GLsizei length, GLchar const *message, void const *) -> void
+      {
+        auto const lock = std::scoped_lock{s_check_state.mutex};
+        if (s_check_state.reported.size() < s_max_reported)
+          s_check_state.reported.emplace_back(message, length < 0 ? std::char_traits<char>::length(message) : static_cast<size_t>(length));
+      };
+      glEnable(s_debug_output_khr);
+      message_control(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+      message_control(GL_DONT_CARE, s_debug_type_error_khr, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+      message_callback(callback, nullptr);
+      /* synchronous output calls back inside the failing call, so the next check is the one after it */
+      if (state.level == check_level::per_call) glEnable(s_debug_output_synchronous_khr);
+      else glDisable(s_debug_output_synchronous_khr);
+      state.debug_output = true;
+      return state.level;
+    }
+  }
+  if (std::exchange(state.debug_output, false)) glDisable(s_debug_output_khr);
+  return state.level;
+}
+auto engine::utilities::gl::report_errors(std::source_location source_location) -> void
+{
+  auto      &state  = s_check_state;
+  auto const recent = [&state] -> std::string
+  {
+    auto trail = std::string{};
+    for (auto const i : std::views::iota(0zu, std::min(state.next, check_state::s_breadcrumb_count)))
+    {
+      auto const &where = state.breadcrumbs.at((state.next - 1zu - i) % check_state::s_breadcrumb_count);
+      std::format_to(std::back_inserter(trail), "{}{}:{}", i ? ", " : "", where.file_name(), where.line());
+    }
+    return trail;
+  };
+  if (state.debug_output)
+  {
+    auto message = std::string{};
+    {
+      auto const lock = std::scoped_lock{state.mutex};
+      if (state.reported.empty()) return;
+      message = std::move(state.reported.front());
+      state.reported.erase(state.reported.begin());
+    }
+    runtime_assert<error>(false, "OpenGL Error: \"{}\" reported by {}:{}:{} in function {}, recent checks: {}", //
+                          message,
+                          source_location.file_name(),
+                          source_location.line(),
+                          source_location.column(),
+                          source_location.function_name(),
+                          recent());
+  }
+  while (auto const e = glGetError() - GL_NO_ERROR)
+    if (state.level == check_level::per_call)
+      runtime_assert<error>(false, "OpenGL Error: \"{}\" from {}:{}:{} in function {}", //
+                            error_to_string(e + GL_NO_ERROR),
+                            source_location.file_name(),
+                            source_location.line(),
+                            source_location.column(),
+                            source_location.function_name());
+    else
+      runtime_assert<error>(false, "OpenGL Error: \"{}\" found by {}:{}:{} in function {}, recent checks: {}", //
+                            error_to_string(e + GL_NO_ERROR),
+                            source_location.file_name(),
+                            source_location.line(),
+                            source_location.column(),
+                            source_location.function_name(),
+                            recent());
+}
+
+engine::renderer::handle_cache::~handle_cache()
+{
+  if (not m_allocator) return;
+  auto names = std::vector<uint32_t>{};
+  names.reserve(m_slots.size());
+  for (auto const &slot : m_slots)
+    if (slot.name) names.push_back(slot.name);
+  if (not names.empty()) m_allocator->delete_handles(names);
 }
 auto engine::renderer::handle_cache::reserve(size_t capacity) -> void
 {
-  if (m_capacity >= capacity) return;
-  set_capacity(std::bit_ceil(capacity));
+  if (this->capacity() >= capacity) return;
+  runtime_assert(m_allocator, "null {} access", "allocator");
+  runtime_assert(capacity <= std::numeric_limits<slot_index_t>::max(), "max possible capacity exceeded");
+  auto const count = capacity - this->capacity();
+  auto       names = std::vector<uint32_t>(count);
+  m_allocator->create_handles(names);
+  m_statistics.creations += count;
+  /* new names are cold: placed in front so warm names keep being reused first */
+  auto fresh = std::vector<slot_index_t>{};
+  fresh.reserve(count);
+  for (auto const name : names)
+  {
+    auto const index = m_unnamed.empty() ? static_cast<slot_index_t>(m_slots.size()) : m_unnamed.back();
+    if (m_unnamed.empty()) m_slots.emplace_back();
+    else /*           */ m_unnamed.pop_back();
+    m_slots[index].name = name;
+    m_slot_of.insert_or_assign(name, index);
+    fresh.push_back(index);
+  }
+  m_free.insert(m_free.begin(), fresh.begin(), fresh.end());
+}
+auto engine::renderer::handle_cache::trim(size_t retained) -> void
+{
+  if (m_free.size() <= retained) return;
+  runtime_assert(m_allocator, "null {} access", "allocator");
+  auto const cold  = std::span{m_free}.first(m_free.size() - retained);
+  auto       names = std::vector<uint32_t>{};
+  names.reserve(cold.size());
+  for (auto const index : cold)
+  {
+    auto &slot = m_slots[index];
+    m_slot_of.erase(slot.name);
+    names.push_back(std::exchange(slot.name, 0u));
+    slot.generation++;
+    m_unnamed.push_back(index);
+  }
+  m_allocator->delete_handles(names);
+  m_statistics.deletions += names.size();
+  m_free.erase(m_free.begin(), m_free.begin() + static_cast<ptrdiff_t>(cold.size()));
+}
+auto engine::renderer::handle_cache::acquire() -> handle
+{
+  if (m_free.empty()) reserve(capacity() + std::max(s_minimum_batch_reserve_size, capacity() / 2zu));
+  auto const index = m_free.back();
+  auto      &slot  = m_slots[index];
+  m_free.pop_back();
+  slot.active = true;
+  m_active++;
+  m_statistics.activations++;
+  return {.name = slot.name, .slot = index, .generation = slot.generation};
+}
+auto engine::renderer::handle_cache::release(handle value) -> void
+{
+  runtime_assert(is_valid(value), "stale or inactive handle {} (slot {}, generation {})", value.name, value.slot, value.generation);
+  auto &slot  = m_slots[value.slot];
+  slot.active = false;
+  slot.generation++;
+  m_active--;
+  m_statistics.deactivations++;
+  if (m_allocator->recycle) return m_free.push_back(value.slot);
+  m_slot_of.erase(slot.name);
+  auto name = std::exchange(slot.name, 0u);
+  m_allocator->delete_handles(std::span{&name, 1zu});
+  m_statistics.deletions++;
+  m_unnamed.push_back(value.slot);
+}
+auto engine::renderer::handle_cache::is_valid(handle value) const noexcept -> bool
+{
+  if (value.slot >= m_slots.size()) return false;
+  auto const &slot = m_slots[value.slot];
+  return slot.active and slot.name == value.name and slot.generation == value.generation;
+}
+auto engine::renderer::handle_cache::deactivate(uint32_t name) -> void
+{
+  auto const it = m_slot_of.find(name);
+  runtime_assert(it != m_slot_of.end() and m_slots[it->second].active, "handle {} not active", name);
+  auto const &slot = m_slots[it->second];
+  release({.name = name, .slot = it->second, .generation = slot.generation});
+}
+
+auto engine::renderer::trim() -> void
+{
+  for (auto *const cache : {&buffers, &framebuffers, &renderbuffers, &textures, &vertexarrays}) cache->trim();
+  state.invalidate(); /* deleted names may have been bound, gl silently rebinds them to 0 */
+}
+
+auto engine::renderer::state_cache::use_program(uint32_t program) -> void
+{
+  if (m_program == program) return skip();
+  glUseProgram(m_program = program), issue();
+}
+auto engine::renderer::state_cache::bind_vertex_array(uint32_t vertex_array) -> void
+{
+  if (m_vertex_array == vertex_array) return skip();
+  glBindVertexArray(m_vertex_array = vertex_array), issue();
+}
+auto engine::renderer::state_cache::bind_buffer(GLenum target, uint32_t buffer) -> void
+{
+  auto const it = std::ranges::find(s_buffer_targets, target);
+  if (it == s_buffer_targets.end()) return glBindBuffer(target, buffer), issue(); /* untracked, e.g. vertex array owned element buffer */
+  auto &bound = m_buffers.at(static_cast<size_t>(it - s_buffer_targets.begin()));
+  if (bound == buffer) return skip();
+  glBindBuffer(target, bound = buffer), issue();
+}
+auto engine::renderer::state_cache::bind_framebuffer(GLenum target, uint32_t framebuffer) -> void
+{
+  auto const draw = target == GL_FRAMEBUFFER or target == GL_DRAW_FRAMEBUFFER;
+  auto const read = target == GL_FRAMEBUFFER or target == GL_READ_FRAMEBUFFER;
+  runtime_assert(draw or read, "invalid framebuffer target {}", target);
+  if (framebuffer == 0u) framebuffer = m_default_framebuffer;
+  if ((not draw or m_draw_framebuffer == framebuffer) and
+      (not read or m_read_framebuffer == framebuffer)) return skip();
+  if (draw) m_draw_framebuffer = framebuffer;
+  if (read) m_read_framebuffer = framebuffer;
+  glBindFramebuffer(target, framebuffer), issue();
+}
+auto engine::renderer::state_cache::bind_texture(uint32_t unit, GLenum target, uint32_t texture) -> void
+{
+  runtime_assert(unit < s_texture_unit_count, "texture unit {} exceeds {} tracked units", unit, s_texture_unit_count);
+  auto const it    = std::ranges::find(s_texture_targets, target);
+  runtime_assert(it != s_texture_targets.end(), "invalid texture target {}", target);
+  auto      &bound = m_textures[unit][static_cast<size_t>(it - s_texture_targets.begin())];
+  if (bound == texture) return skip();
+  if (m_active_texture != unit) glActiveTexture(GL_TEXTURE0 + (m_active_texture = unit)), issue();
+  glBindTexture(target, bound = texture), issue();
+}
+auto engine::renderer::state_cache::uniform(int32_t location, uniform_value_t const &value) -> void
+{
+  runtime_assert(m_program != s_unknown, "uniform set without a {} program", "known");
+  if (location < 0) return; /* inactive uniform, ignored by gl as well */
+  auto const key            = static_cast<uint64_t>(m_program) << 32 | static_cast<uint32_t>(location);
+  auto const [it, inserted] = m_uniforms.try_emplace(key, value);
+  if (not inserted and it->second == value) return skip();
+  it->second = value;
+  std::visit(
+      [location]<typename T>(T const &v)
+      {
+        /**/ if constexpr (std::same_as<T, GLint /*     */>) glUniform1i(location, v);
+        else if constexpr (std::same_as<T, GLuint /*    */>) glUniform1ui(location, v);
+        else if constexpr (std::same_as<T, GLfloat /*   */>) glUniform1f(location, v);
+        else if constexpr (std::same_as<T, glm::ivec2 /**/>) glUniform2iv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::ivec3 /**/>) glUniform3iv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::ivec4 /**/>) glUniform4iv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::uvec2 /**/>) glUniform2uiv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::uvec3 /**/>) glUniform3uiv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::uvec4 /**/>) glUniform4uiv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::vec2 /* */>) glUniform2fv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::vec3 /* */>) glUniform3fv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::vec4 /* */>) glUniform4fv(location, 1, &v[0]);
+        else if constexpr (std::same_as<T, glm::mat2 /* */>) glUniformMatrix2fv(location, 1, GL_FALSE, &v[0][0]);
+        else if constexpr (std::same_as<T, glm::mat3 /* */>) glUniformMatrix3fv(location, 1, GL_FALSE, &v[0][0]);
+        else if constexpr (std::same_as<T, glm::mat4 /* */>) glUniformMatrix4fv(location, 1, GL_FALSE, &v[0][0]);
+        else static_assert(false);
+      },
+      value);
+  issue();
+}
+auto engine::renderer::state_cache::forget_program(uint32_t program) -> void
+{
+  std::erase_if(m_uniforms, [program](auto const &entry)
+                { return static_cast<uint32_t>(entry.first >> 32) == program; });
+  if (m_program == program) m_program = s_unknown;
+}
+auto engine::renderer::state_cache::invalidate() noexcept -> void
+{
+  m_program          = s_unknown;
+  m_vertex_array     = s_unknown;
+  m_draw_framebuffer = s_unknown;
+  m_read_framebuffer = s_unknown;
+  m_active_texture   = s_unknown;
+  m_buffers.fill(s_unknown);
+  for (auto &unit : m_textures) unit.fill(s_unknown);
+  m_uniforms.clear();
+}
+auto engine::renderer::state_cache::begin_frame() noexcept -> void
+{
+  m_last_frame = std::exchange(m_frame, {});
 }
 
-auto engine::renderer::handle_cache::activate() -> uint32_t
+auto engine::renderer::command_list::record(packet const &packet) -> void
+{
+  auto const copy_into_arena = [this]<typename T>(std::span<T const> values) -> std::span<T const>
+  {
+    if (values.empty()) return {};
+    auto const data = static_cast<T *>(m_arena->resource.allocate(values.size_bytes(), alignof(T)));
+    std::ranges::uninitialized_copy(values, std::span{data, values.size()});
+    return {data, values.size()};
+  };
+  auto const is_clear = std::holds_alternative<clear>(packet.command);
+  if (is_clear and not m_entries.empty()) barrier();
+  auto const texture = packet.textures.empty() ? 0u : packet.textures.front().texture;
+  m_entries.push_back({
+      .key  = {.group = m_group, .program = packet.program, .vertex_array = packet.vertex_array, .texture = texture},
+      .data = {
+          .program      = packet.program,
+          .vertex_array = packet.vertex_array,
+          .textures     = copy_into_arena(packet.textures),
+          .uniforms     = copy_into_arena(packet.uniforms),
+          .command      = packet.command,
+      },
+  });
+  if (is_clear) barrier();
+}
+auto engine::renderer::command_list::barrier() -> void
+{
+  if (m_entries.empty() or m_entries.back().key.group != m_group) return; /* nothing recorded since last barrier */
+  runtime_assert(m_group != std::numeric_limits<decltype(m_group)>::max(), "{} barrier overflow", "command list");
+  m_group++;
+}
+auto engine::renderer::command_list::submit(state_cache &state) -> void
+{
+  if (m_entries.empty()) return reset();
+  std::ranges::stable_sort(m_entries, std::ranges::less{}, &entry::key);
+  try
+  {
+    for (auto const &[key, packet] : m_entries)
+    {
+      (void)key;
+      std::visit(
+          [&state, &packet]<typename T>(T const &command)
+          {
+            if constexpr (std::same_as<T, clear>)
+            {
+              glClearColor(command.color.r, command.color.g, command.color.b, command.color.a);
+              glClear(command.mask);
+              return;
+            }
+            else
+            {
+              state.use_program(packet.program);
+              state.bind_vertex_array(packet.vertex_array);
+              for (auto const &[unit, target, texture] : packet.textures) state.bind_texture(unit, target, texture);
+              for (auto const &[location, value] : packet.uniforms) state.uniform(location, value);
+              /**/ if constexpr (std::same_as<T, draw_arrays>)
+                glDrawArraysInstanced(command.mode, command.first, command.count, command.instances);
+              else if constexpr (std::same_as<T, draw_elements>)
+                glDrawElementsInstanced(command.mode, command.count, command.type, reinterpret_cast<void const *>(command.offset), command.instances);
+              else
+                static_assert(false);
+            }
+          },
+          packet.command);
+    }
+    glCheckError();
+  }
+  catch (...)
+  {
+    reset(); /* a failed frame drops its packets, they may name objects gone by the next one */
+    throw;
+  }
+  reset();
+}
+auto engine::renderer::command_list::reset() -> void
+{
+  m_last_packet_count = m_entries.size();
+  m_last_group_count  = m_entries.empty() ? 0zu : 1zu + m_entries.back().key.group - m_entries.front().key.group;
+  m_entries           = std::pmr::vector<entry>{&m_arena->resource}; /* storage is reclaimed by the arena release below */
+  m_group             = 0u;
+  m_arena->resource.release();
+}
+
+struct engine::renderer::program_cache::writer
+{
+  public:
+    struct job
+    {
+        std::filesystem::path path = {};
+        std::string /*     */ data = {}; /* header and binary */
+    };
+
+    /**/ inline writer()
+    {
+      m_thread = std::jthread{[this](std::stop_token stop)
+                              {
+                                auto lock = std::unique_lock{m_mutex};
+                                while (true)
+                                {
+                                  m_wake.wait(lock, stop, [this] { return not m_jobs.empty(); });
+                                  if (m_jobs.empty()) break; /* stopped, and everything queued before is written */
+                                  auto next = std::move(m_jobs.front());
+                                  m_jobs.pop_front();
+                                  lock.unlock();
+                                  if (write(next)) m_written.fetch_add(1u, std::memory_order_relaxed);
+                                  lock.lock();
+                                }
+                              }};
+    }
+    auto inline push(job value) -> void
+    {
+      auto lock = std::scoped_lock{m_mutex};
+      m_jobs.push_back(std::move(value));
+      m_wake.notify_all();
+    }
+    auto inline get_written() const noexcept -> uint64_t { return m_written.load(std::memory_order_relaxed); }
+
+  private:
+    auto static write(job const &value) -> bool
+    {
+      auto       ec        = std::error_code{};
+      auto const directory = value.path.parent_path();
+      auto const temp      = std::filesystem::path{value.path}.replace_extension(std::format("{:08x}{:08x}.tmp", std::random_device{}(), std::random_device{}())); /* concurrent instances */
+      if (std::filesystem::create_directories(directory, ec) and not ec)
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace, ec);
+      if (ec) return false;
+      if (auto file = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+          not file.write(value.data.data(), static_cast<std::streamsize>(value.data.size()))) return std::filesystem::remove(temp, ec), false;
+      if (std::filesystem::rename(temp, value.path, ec); ec) return std::filesystem::remove(temp, ec), false;
+      return true;
+    }
+
+    std::mutex /*               */ m_mutex   = {};
+    std::condition_variable_any m_wake    = {};
+    std::deque<job> /*          */ m_jobs    = {};
+    std::atomic<uint64_t> /*    */ m_written = 0u;
+    std::jthread /*             */ m_thread  = {}; /* declared last, drains and joins before the rest is destroyed */
+};
+engine::renderer::program_cache::program_cache() noexcept {}
+engine::renderer::program_cache::program_cache(program_cache &&o) noexcept
+{
+  m_entries      = std::exchange(o.m_entries /*      */, {});
+  m_keys         = std::exchange(o.m_keys /*         */, {});
+  m_unreferenced = std::exchange(o.m_unreferenced /* */, {});
+  m_directory    = std::exchange(o.m_directory /*    */, {});
+  m_persistence  = std::exchange(o.m_persistence /*  */, {});
+  m_driver_hash  = std::exchange(o.m_driver_hash /*  */, {});
+  m_parallel     = std::exchange(o.m_parallel /*     */, {});
+  m_frame        = std::exchange(o.m_frame /*        */, {});
+  m_writer       = std::exchange(o.m_writer /*       */, {});
+  m_statistics   = std::exchange(o.m_statistics /*   */, {});
+}
+engine::renderer::program_cache::~program_cache()
+{
+  for (auto const &[key, entry] : m_entries)
+  {
+    for (auto const shader : entry.shaders) glDeleteShader(shader);
+    glDeleteProgram(entry.program);
+  }
+}
+auto engine::renderer::program_cache::hash_sources(std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) noexcept -> uint64_t
+{
+  auto hash = utilities::hash_fnv1a_offset_basis;
+  for (auto const &[stage, sources] : {std::pair{"vertex", vertex_sources}, std::pair{"fragment", fragment_sources}})
+  {
+    hash = utilities::hash_fnv1a(stage, hash);
+    for (auto const source : sources) hash = utilities::hash_fnv1a(source, utilities::hash_fnv1a(std::string_view{"\0", 1zu}, hash));
+  }
+  return hash;
+}
+auto engine::renderer::program_cache::acquire(std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) -> uint32_t
+{
+  auto const program = acquire_async(vertex_sources, fragment_sources);
+  auto const key     = m_keys.at(program);
+  auto      &entry   = m_entries.at(key);
+  resolve(key, entry, /* wait */ true);
+  if (entry.status == program_status::failed)
+  {
+    if (--entry.references == 0zu) m_unreferenced.push_back(key);
+    throw utilities::runtime_assert_failure{entry.error};
+  }
+  return program;
+}
+auto engine::renderer::program_cache::acquire_async(std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources) -> uint32_t
+{
+  auto const key = hash_sources(vertex_sources, fragment_sources);
+  if (auto const it = m_entries.find(key); it != m_entries.end())
+  {
+    if (it->second.references++ == 0zu) std::erase(m_unreferenced, key);
+    m_statistics.hits++;
+    return it->second.program;
+  }
+  auto entry = program_cache::entry{.program = glCreateProgram(), .references = 1zu, .frame = m_frame};
+  try
+  {
+    if (load_binary(entry.program, key))
+    {
+      entry.status = program_status::ready;
+    }
+    else
+    {
+      entry.shaders = {glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER)};
+      submit_shader(entry.shaders[0], vertex_sources);
+      submit_shader(entry.shaders[1], fragment_sources);
+      if (persistence_available()) glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+      submit_program(entry.program, entry.shaders);
+      glCheckError();
+    }
+  }
+  catch (...)
+  {
+    for (auto const shader : entry.shaders) glDeleteShader(shader);
+    glDeleteProgram(entry.program);
+    throw;
+  }
+  auto const program = entry.program;
+  m_entries.insert({key, std::move(entry)});
+  m_keys.insert({program, key});
+  return program;
+}
+auto engine::renderer::program_cache::poll() -> void
+{
+  m_frame++;
+  if (m_writer) m_statistics.disk_writes = m_writer->get_written();
+  for (auto &[key, entry] : m_entries)
+  {
+    if (entry.status != program_status::pending) continue;
+    resolve(key, entry, /* wait */ false);
+    if (entry.status == program_status::failed)
+      std::println(stderr, "Error in {:?}: {}", "Program compile", entry.error);
+  }
+}
+auto engine::renderer::program_cache::get_status(uint32_t program) const -> program_status
+{
+  auto const it = m_keys.find(program);
+  runtime_assert(it != m_keys.end(), "program {} not in program cache", program);
+  return m_entries.at(it->second).status;
+}
+auto engine::renderer::program_cache::resolve(uint64_t key, entry &entry, bool wait) -> void
+{
+  if (entry.status != program_status::pending) return;
+  if (not wait)
+  {
+    if (parallel_available())
+    {
+      if (GLint done; glGetProgramiv(entry.program, s_completion_status_khr, &done), not done) return;
+    }
+    else if (entry.frame == m_frame) return; /* give the driver a frame before the status query blocks */
+  }
+  try
+  {
+    for (auto const shader : entry.shaders) check_shader(shader);
+    check_program(entry.program);
+    entry.status = program_status::ready;
+  }
+  catch (std::exception const &e)
+  {
+    entry.status = program_status::failed;
+    entry.error  = e.what();
+  }
+  for (auto &shader : entry.shaders) shader = (glDetachShader(entry.program, shader), glDeleteShader(shader), 0u);
+  if (entry.status == program_status::ready)
+  {
+    m_statistics.compiles++;
+    store_binary(entry.program, key);
+  }
+}
+auto engine::renderer::program_cache::release(uint32_t program, state_cache &state) -> void
+{
+  auto const it = m_keys.find(program);
+  runtime_assert(it != m_keys.end(), "program {} not in program cache", program);
+  auto const key   = it->second;
+  auto      &entry = m_entries.at(key);
+  runtime_assert(entry.references > 0zu, "program {} released more times than acquired", program);
+  if (--entry.references > 0zu) return;
+  m_unreferenced.push_back(key); /* kept warm so the next acquire skips compile and link */
+  if (m_unreferenced.size() > s_retained_unreferenced) evict(m_unreferenced.front(), state);
+}
+auto engine::renderer::program_cache::trim(state_cache &state) -> void
+{
+  while (not m_unreferenced.empty()) evict(m_unreferenced.front(), state);
+}
+auto engine::renderer::program_cache::evict(uint64_t key, state_cache &state) -> void
+{
+  auto const program = m_entries.at(key).program;
+  std::erase(m_unreferenced, key);
+  m_entries.erase(key);
+  m_keys.erase(program);
+  state.forget_program(program);
+  glDeleteProgram(program);
+}
+auto engine::renderer::program_cache::set_directory(std::filesystem::path directory) -> void
+{
+  m_directory = std::move(directory);
+}
+auto engine::renderer::program_cache::get_directory() -> std::filesystem::path const &
+{
+  if (not m_directory.empty()) return m_directory;
+  /* per user, a shared temp directory would let other local users plant binaries for the driver to load */
+  auto base = std::filesystem::path{};
+#if /* */ defined(_WIN32) or defined(_WIN64)
+  auto *value = static_cast<char *>(nullptr);
+  auto  size  = size_t{};
+  if (_dupenv_s(&value, &size, "LOCALAPPDATA") == 0 and value) base = value;
+  std::free(value);
+#else  // defined(_WIN32) or defined(_WIN64)
+  if (auto const xdg = std::getenv("XDG_CACHE_HOME"); xdg and *xdg) base = xdg;
+  else if (auto const home = std::getenv("HOME"); home and *home) base = std::filesystem::path{home} / ".cache";
+#endif // defined(_WIN32) or defined(_WIN64)
+  if (base.empty() or not base.is_absolute()) return m_directory; /* empty, binaries are neither loaded nor stored */
+  return m_directory = base / "OpenGL-Game" / "program-cache";
+}
+auto engine::renderer::program_cache::parallel_available() -> bool
+{
+  if (not m_parallel.has_value()) m_parallel = has_extension("GL_KHR_parallel_shader_compile");
+  return *m_parallel;
+}
+auto engine::renderer::program_cache::persistence_available() -> bool
+{
+  if (not m_persistence.has_value())
+  {
+    auto formats = GLint{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    m_persistence = formats > 0;
+  }
+  return *m_persistence;
+}
+auto engine::renderer::program_cache::driver_hash() -> uint64_t
+{
+  if (m_driver_hash.has_value()) return *m_driver_hash;
+  auto hash = utilities::hash_fnv1a_offset_basis;
+  for (auto const name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION})
+    if (auto const str = reinterpret_cast<char const *>(glGetString(name)))
+      hash = utilities::hash_fnv1a(str, hash);
+  return *(m_driver_hash = hash);
+}
+auto engine::renderer::program_cache::binary_path(uint64_t key) -> std::filesystem::path
 {
-  if (m_size >= m_capacity) reserve(1zu + m_size + s_minimum_batch_reserve_size);
-  return m_handles[m_size++];
+  return get_directory() / std::format("{:016x}.bin", key);
 }
-auto engine::renderer::handle_cache::deactivate(uint32_t handle) -> void
+auto engine::renderer::program_cache::load_binary(uint32_t program, uint64_t key) -> bool
 {
-  auto const active_reverse = std::views::reverse(active());
-  auto const it             = std::ranges::find(active_reverse, handle);
-  runtime_assert(it != active_reverse.end(), "handle {} not active", handle);
-  std::swap(*it, all()[--m_size]);
+#if /* */ defined(__EMSCRIPTEN__)
+  (void)program, (void)key;
+  return false;
+#else  // defined(__EMSCRIPTEN__)
+  if (not persistence_available() or get_directory().empty()) return false;
+  auto const path   = binary_path(key);
+  auto const reject = [this, &path]
+  {
+    while (glGetError() != GL_NO_ERROR) { /* drain errors from a rejected binary */ }
+    auto ec = std::error_code{};
+    std::filesystem::remove(path, ec);
+    m_statistics.disk_rejects++;
+    return false;
+  };
+  auto const bytes = utilities::mapped_file::open(path); /* handed to the driver without a copy */
+  if (not bytes) return false;
+  auto header = binary_header{};
+  if (bytes->size() < sizeof(header)) return reject();
+  std::ranges::copy_n(bytes->data(), sizeof(header), reinterpret_cast<std::byte *>(&header));
+  if (header.magic != binary_header{}.magic or
+      header.source_hash != key or
+      header.driver_hash != driver_hash() or
+      bytes->size() != sizeof(header) + header.length) return reject();
+  glProgramBinary(program, header.format, bytes->data() + sizeof(header), static_cast<GLsizei>(header.length));
+  if (GLint status; glGetProgramiv(program, GL_LINK_STATUS, &status), not status) return reject();
+  m_statistics.disk_loads++;
+  return true;
+#endif // defined(__EMSCRIPTEN__)
+}
+auto engine::renderer::program_cache::store_binary(uint32_t program, uint64_t key) -> void
+{
+#if /* */ defined(__EMSCRIPTEN__)
+  (void)program, (void)key;
+#else  // defined(__EMSCRIPTEN__)
+  if (not persistence_available() or get_directory().empty()) return;
+  auto length = GLint{};
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  auto header = binary_header{.source_hash = key, .driver_hash = driver_hash()};
+  auto data   = std::string(sizeof(header) + static_cast<size_t>(length), '\0');
+  auto format = GLenum{};
+  auto size   = GLsizei{};
+  glGetProgramBinary(program, length, &size, &format, data.data() + sizeof(header));
+  glCheckError();
+  header.format = static_cast<uint32_t>(format);
+  header.length = static_cast<uint32_t>(size);
+  data.resize(sizeof(header) + header.length);
+  std::ranges::copy_n(reinterpret_cast<char const *>(&header), sizeof(header), data.data());
+  if (not m_writer) m_writer = std::make_unique<writer>();
+  m_writer->push({.path = binary_path(key), .data = std::move(data)}); /* disk io stays off the frame */
+#endif // defined(__EMSCRIPTEN__)
 }
 
+auto engine::renderer::has_extension(std::string_view name) -> bool
+{
+  auto count = GLint{};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (auto const i : std::views::iota(0, count))
+    if (auto const extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        extension and name == extension) return true;
+  return false;
+}
 auto engine::renderer::compile_shader(uint32_t shader, std::span<std::string_view const> shader_sources) -> void
+{
+  submit_shader(shader, shader_sources);
+  check_shader(shader);
+}
+auto engine::renderer::submit_shader(uint32_t shader, std::span<std::string_view const> shader_sources) -> void
 {
   runtime_assert(not shader_sources.empty(), "can not compile a shader from no sources");
   auto const version_offset = shader_sources.front().find("#version");
@@ -53,6 +718,9 @@ auto engine::renderer::compile_shader(uint32_t shader, std::span<std::string_vie
   lengths.front()                        -= static_cast<GLsizei>(version_offset);
   glShaderSource(shader, static_cast<GLsizei>(shader_sources.size()), sources.data(), lengths.data());
   glCompileShader(shader);
+}
+auto engine::renderer::check_shader(uint32_t shader) -> void
+{
   if (GLint status; glGetShaderiv(shader, GL_COMPILE_STATUS, &status), not status)
   {
     auto [log, length] = std::tuple{std::string{}, GLsizei{}};
@@ -64,9 +732,17 @@ auto engine::renderer::compile_shader(uint32_t shader, std::span<std::string_vie
   glCheckError();
 }
 auto engine::renderer::link_program(uint32_t program, std::span<uint32_t const> shaders) -> void
+{
+  submit_program(program, shaders);
+  check_program(program);
+}
+auto engine::renderer::submit_program(uint32_t program, std::span<uint32_t const> shaders) -> void
 {
   for (auto shader : shaders) glAttachShader(program, shader);
   glLinkProgram(program);
+}
+auto engine::renderer::check_program(uint32_t program) -> void
+{
   if (GLint status; glGetProgramiv(program, GL_LINK_STATUS, &status), not status)
   {
     auto [log, length] = std::tuple{std::string{}, GLsizei{}};
@@ -76,4 +752,548 @@ auto engine::renderer::link_program(uint32_t program, std::span<uint32_t const>
     runtime_assert(false, "{} Error: {}", "Program Link", log);
   }
   glCheckError();
-}
\ No newline at end of file
+}
+engine::renderer::gpu_timer::~gpu_timer()
+{
+  if (m_queries.front() != 0u) glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+auto engine::renderer::gpu_timer::is_supported() -> bool
+{
+  if (not m_supported.has_value())
+    m_supported = has_extension("GL_EXT_disjoint_timer_query") or has_extension("GL_EXT_disjoint_timer_query_webgl2");
+  return *m_supported;
+}
+auto engine::renderer::gpu_timer::begin() -> void
+{
+  runtime_assert(not m_active, "{} begin without an end", "gpu timer");
+  if (not is_supported() or m_pending.at(m_next)) return;
+  if (m_queries.front() == 0u) glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+  m_begins.at(m_next) = clock::now();
+  glBeginQuery(s_time_elapsed_ext, m_queries.at(m_next));
+  m_active = true;
+}
+auto engine::renderer::gpu_timer::end() -> void
+{
+  if (not std::exchange(m_active, false)) return;
+  glEndQuery(s_time_elapsed_ext);
+  m_pending.at(m_next) = true;
+  m_next               = (m_next + 1zu) % s_query_count;
+}
+auto engine::renderer::gpu_timer::poll() -> std::span<sample const>
+{
+  auto count = 0zu;
+  if (not is_supported()) return {};
+  for (auto const i : std::views::iota(0zu, s_query_count))
+  {
+    auto const slot = (m_next + i) % s_query_count; /* oldest first, results complete in order */
+    if (not m_pending.at(slot)) continue;
+    auto available = GLuint{};
+    glGetQueryObjectuiv(m_queries.at(slot), GL_QUERY_RESULT_AVAILABLE, &available);
+    if (not available) break;
+    auto nanoseconds = GLuint{}; /* 32 bits hold a bit over 4 seconds, plenty for a frame */
+    glGetQueryObjectuiv(m_queries.at(slot), GL_QUERY_RESULT, &nanoseconds);
+    m_pending.at(slot)   = false;
+    m_completed[count++] = {.begin = m_begins.at(slot), .elapsed = std::chrono::nanoseconds{nanoseconds}};
+  }
+  auto disjoint = GLint{};
+  glGetIntegerv(s_gpu_disjoint_ext, &disjoint);
+  if (disjoint) return {}; /* clock changes or context loss made the results meaningless */
+  if (count) m_last = m_completed.at(count - 1zu);
+  return std::span{m_completed}.first(count);
+}
+struct engine::renderer::frame_capture::encoder
+{
+  public:
+    struct frame
+    {
+        std::vector<uint8_t> rgba = {}; /* bottom row first, as read back */
+        glm::ivec2 /*     */ size = {};
+    };
+
+    /**/ inline encoder(std::filesystem::path path, format kind, uint32_t frame_rate) : m_path{std::move(path)}, m_kind{kind}, m_frame_rate{frame_rate}
+    {
+      if (m_kind == format::png) std::filesystem::create_directories(m_path);
+      else m_file = std::ofstream{m_path, std::ios::binary}, runtime_assert(m_file.is_open(), "could not open capture output {}", m_path.string());
+      m_thread = std::jthread{[this](std::stop_token stop)
+                              {
+                                auto lock = std::unique_lock{m_mutex};
+                                while (true)
+                                {
+                                  m_wake.wait(lock, stop, [this] { return not m_frames.empty(); });
+                                  if (m_frames.empty()) break; /* stopped, and everything queued before is written */
+                                  auto next = std::move(m_frames.front());
+                                  m_frames.pop_front();
+                                  m_wake.notify_all();
+                                  lock.unlock();
+                                  try
+                                  {
+                                    if (not m_error) write(next);
+                                  }
+                                  catch (...)
+                                  {
+                                    m_error = std::current_exception(); /* the rest is dropped, `finish` reports it */
+                                    m_failed.store(true, std::memory_order_release);
+                                  }
+                                  lock.lock();
+                                }
+                              }};
+    }
+    auto inline push(frame value) -> bool /* whether it had to wait for room */
+    {
+      auto lock   = std::unique_lock{m_mutex};
+      auto waited = m_frames.size() >= s_encoder_depth;
+      m_wake.wait(lock, [this] { return m_frames.size() < s_encoder_depth; });
+      m_frames.push_back(std::move(value));
+      m_wake.notify_all();
+      return waited;
+    }
+    auto inline finish() -> void
+    {
+      m_thread = {};
+      m_file.close();
+      if (m_error) std::rethrow_exception(std::exchange(m_error, {}));
+    }
+    auto inline get_encoded() const noexcept -> uint64_t { return m_encoded.load(std::memory_order_relaxed); }
+    auto inline has_failed() const noexcept -> bool { return m_failed.load(std::memory_order_acquire); }
+
+  private:
+    auto write(frame const &value) -> void
+    {
+      auto const [width, height] = std::array{static_cast<size_t>(value.size.x), static_cast<size_t>(value.size.y)};
+      auto const row             = [&](size_t y) { return std::span{value.rgba}.subspan((height - 1zu - y) * width * 4zu, width * 4zu); }; /* top down */
+      if (m_kind == format::y4m)
+      {
+        if (m_encoded == 0u)
+          m_file << std::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", width, height, m_frame_rate), m_size = value.size;
+        runtime_assert(value.size == m_size, "{} frame size changed mid stream", "y4m");
+        auto planes = std::vector<uint8_t>(width * height * 3zu);
+        for (auto const y : std::views::iota(0zu, height))
+          for (auto const [x, pixel] : std::views::enumerate(row(y) | std::views::chunk(4)))
+          {
+            auto const [r, g, b] = std::array{static_cast<double>(pixel[0]), static_cast<double>(pixel[1]), static_cast<double>(pixel[2])}; /* bt.601 full range */
+            auto const i         = y * width + static_cast<size_t>(x);
+            planes[i]                        = static_cast<uint8_t>(std::clamp(std::round(/*  */ 0.299 * r + 0.587000 * g + 0.114000 * b), 0.0, 255.0));
+            planes[i + width * height]       = static_cast<uint8_t>(std::clamp(std::round(128.0 - 0.168736 * r - 0.331264 * g + 0.500000 * b), 0.0, 255.0));
+            planes[i + width * height * 2zu] = static_cast<uint8_t>(std::clamp(std::round(128.0 + 0.500000 * r - 0.418688 * g - 0.081312 * b), 0.0, 255.0));
+          }
+        m_file << "FRAME\n";
+        m_file.write(reinterpret_cast<char const *>(planes.data()), static_cast<std::streamsize>(planes.size()));
+        runtime_assert(m_file.good(), "could not write capture output {}", m_path.string());
+      }
+      else /* png with stored deflate blocks, lossless and cheap to produce */
+      {
+        auto static constexpr crc_table = [] static
+        {
+          auto table = std::array<uint32_t, 256>{};
+          for (auto const n : std::views::iota(0u, 256u))
+          {
+            auto c = n;
+            for (auto k = 0; k < 8; k++) c = c & 1u ? 0xED'B8'83'20u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+          }
+          return table;
+        }();
+        auto bytes     = std::vector<uint8_t>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        auto const u32 = [&bytes](uint32_t value) { for (auto const shift : {24, 16, 8, 0}) bytes.push_back(static_cast<uint8_t>(value >> shift)); };
+        auto const chunk = [&](std::string_view type, std::span<uint8_t const> data)
+        {
+          u32(static_cast<uint32_t>(data.size()));
+          auto const begin = bytes.size();
+          bytes.insert(bytes.end(), type.begin(), type.end());
+          bytes.insert(bytes.end(), data.begin(), data.end());
+          auto crc = 0xFF'FF'FF'FFu;
+          for (auto const byte : std::span{bytes}.subspan(begin)) crc = crc_table[(crc ^ byte) & 0xFFu] ^ (crc >> 8);
+          u32(crc ^ 0xFF'FF'FF'FFu);
+        };
+        auto header = std::array<uint8_t, 13>{};
+        for (auto const [i, value] : std::views::enumerate(std::array{static_cast<uint32_t>(width), static_cast<uint32_t>(height)}))
+          for (auto const [j, shift] : std::views::enumerate(std::array{24, 16, 8, 0})) header[static_cast<size_t>(i * 4 + j)] = static_cast<uint8_t>(value >> shift);
+        header[8] = 8u, header[9] = 6u; /* 8 bit rgba, deflate, adaptive filtering, not interlaced */
+        chunk("IHDR", header);
+
+        auto scanlines = std::vector<uint8_t>{};
+        scanlines.reserve(height * (1zu + width * 4zu));
+        for (auto const y : std::views::iota(0zu, height)) /* filter type none */
+          scanlines.push_back(0u), scanlines.insert(scanlines.end(), row(y).begin(), row(y).end());
+        auto zlib       = std::vector<uint8_t>{0x78, 0x01};
+        auto [a, b]     = std::array{1u, 0u}; /* adler32 */
+        auto const last = std::max<size_t>(1zu, (scanlines.size() + 0xFF'FEzu) / 0xFF'FFzu);
+        for (auto const [i, block] : std::views::enumerate(scanlines | std::views::chunk(0xFF'FFzu)))
+        {
+          auto const length = static_cast<uint16_t>(block.size());
+          zlib.push_back(static_cast<size_t>(i) + 1zu == last ? 1u : 0u);
+          for (auto const value : {length, static_cast<uint16_t>(~length)}) zlib.push_back(static_cast<uint8_t>(value)), zlib.push_back(static_cast<uint8_t>(value >> 8));
+          zlib.insert(zlib.end(), block.begin(), block.end());
+          for (auto const byte : block) a = (a + byte) % 65'521u, b = (b + a) % 65'521u;
+        }
+        for (auto const shift : {24, 16, 8, 0}) zlib.push_back(static_cast<uint8_t>(((b << 16) | a) >> shift));
+        chunk("IDAT", zlib);
+        chunk("IEND", {});
+
+        auto const path = m_path / std::format("frame_{:06}.png", m_encoded.load(std::memory_order_relaxed));
+        auto file       = std::ofstream{path, std::ios::binary};
+        file.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        runtime_assert(file.good(), "could not write capture output {}", path.string());
+      }
+      m_encoded.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    std::filesystem::path /*   */ m_path       = {};
+    format /*                  */ m_kind       = format::y4m;
+    uint32_t /*                */ m_frame_rate = 60u;
+    std::ofstream /*           */ m_file       = {};
+    glm::ivec2 /*              */ m_size       = {};
+    std::exception_ptr /*      */ m_error      = {};
+    std::atomic<uint64_t> /*   */ m_encoded    = 0u;
+    std::atomic<bool> /*       */ m_failed     = false; /* set with `m_error`, read by the render thread without the lock */
+    std::mutex /*              */ m_mutex      = {};
+    std::condition_variable_any m_wake       = {};
+    std::deque<frame> /*       */ m_frames     = {};
+    std::jthread /*            */ m_thread     = {}; /* declared last, joined before the rest is destroyed */
+};
+engine::renderer::frame_capture::frame_capture() noexcept {}
+engine::renderer::frame_capture::frame_capture(frame_capture &&o) noexcept
+{
+  m_slots      = std::exchange(o.m_slots /*      */, {});
+  m_next       = std::exchange(o.m_next /*       */, {});
+  m_in_flight  = std::exchange(o.m_in_flight /*  */, {});
+  m_encoder    = std::exchange(o.m_encoder /*    */, {});
+  m_statistics = std::exchange(o.m_statistics /* */, {});
+}
+engine::renderer::frame_capture::~frame_capture() { release(); }
+auto engine::renderer::frame_capture::start(std::filesystem::path path, format value, uint32_t frame_rate) -> void
+{
+#if /* */ defined(__EMSCRIPTEN__)
+  (void)path, (void)value, (void)frame_rate;
+  runtime_assert(false, "{} is unavailable under WebGL, it can not map buffers", "frame capture");
+#else  // defined(__EMSCRIPTEN__)
+  runtime_assert(not is_active(), "{} already started", "frame capture");
+  m_encoder    = std::make_unique<encoder>(std::move(path), value, std::max(frame_rate, 1u));
+  m_statistics = {};
+#endif // defined(__EMSCRIPTEN__)
+}
+auto engine::renderer::frame_capture::read(renderer &owner, glm::ivec2 size) -> void
+{
+  auto &state = owner.state;
+  if (not is_active() or size.x <= 0 or size.y <= 0) return;
+  if (m_in_flight == s_ring_size) /* the oldest readback is the slot about to be reused */
+    settle(m_slots.at(m_next), state), m_statistics.readback_waits++;
+  auto      &slot  = m_slots.at(m_next);
+  auto const bytes = static_cast<GLsizeiptr>(size.x) * size.y * 4;
+  if (not slot.buffer) slot.buffer = owner.buffers.make_unique(), slot.size = {}; /* fresh names have no storage */
+  state.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer.get());
+  if (slot.size != size) glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ), slot.size = size;
+  state.bind_framebuffer(GL_READ_FRAMEBUFFER, 0u);
+  glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); /* into the buffer, returns without waiting */
+  state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0u);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glCheckError();
+  m_next = (m_next + 1zu) % s_ring_size;
+  m_in_flight++;
+  m_statistics.captured++;
+}
+auto engine::renderer::frame_capture::poll(state_cache &state) -> void
+{
+  if (not is_active()) return;
+  if (m_encoder->has_failed()) return stop(state); /* rethrows, later frames would only be read back to be dropped */
+  while (m_in_flight)
+  {
+    auto &oldest = m_slots.at((m_next + s_ring_size - m_in_flight) % s_ring_size);
+    if (auto const status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        status != GL_ALREADY_SIGNALED and status != GL_CONDITION_SATISFIED) break;
+    collect(oldest, state);
+  }
+}
+auto engine::renderer::frame_capture::stop(state_cache &state) -> void
+{
+  if (not is_active()) return;
+  while (m_in_flight) settle(m_slots.at((m_next + s_ring_size - m_in_flight) % s_ring_size), state);
+  m_statistics.encoded = m_encoder->get_encoded();
+  std::exchange(m_encoder, {})->finish();
+}
+auto engine::renderer::frame_capture::get_statistics() const noexcept -> statistics
+{
+  auto result = m_statistics;
+  if (m_encoder) result.encoded = m_encoder->get_encoded();
+  return result;
+}
+auto engine::renderer::frame_capture::release() -> void
+{
+  for (auto &slot : std::exchange(m_slots, {}))
+    if (slot.fence) glDeleteSync(slot.fence);
+  m_next = m_in_flight = 0zu;
+}
+auto engine::renderer::frame_capture::settle(slot &slot, state_cache &state) -> void
+{
+  if (auto const status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::chrono::nanoseconds{std::chrono::seconds{1}}.count());
+      status == GL_ALREADY_SIGNALED or status == GL_CONDITION_SATISFIED) return collect(slot, state);
+  glDeleteSync(std::exchange(slot.fence, {})); /* timed out or failed, mapping would stall or read garbage */
+  m_in_flight--;
+  m_statistics.dropped++;
+}
+auto engine::renderer::frame_capture::collect(slot &slot, state_cache &state) -> void
+{
+  auto value = encoder::frame{.rgba = std::vector<uint8_t>(static_cast<size_t>(slot.size.x) * static_cast<size_t>(slot.size.y) * 4zu), .size = slot.size};
+  state.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer.get());
+  auto const mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(value.rgba.size()), GL_MAP_READ_BIT);
+  runtime_assert(mapped, "{} readback map fail", "frame capture");
+  std::ranges::copy_n(static_cast<uint8_t const *>(mapped), static_cast<std::ptrdiff_t>(value.rgba.size()), value.rgba.data());
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0u);
+  glDeleteSync(std::exchange(slot.fence, {}));
+  m_in_flight--;
+  if (m_encoder->push(std::move(value))) m_statistics.encoder_waits++;
+}
+
+namespace
+{
+  struct sprite_attribute
+  {
+      GLuint location   = 0u;
+      GLint  components = 0;
+      size_t offset     = 0zu;
+  };
+  using sprite_instance          = engine::renderer::sprite_batch::instance;
+  auto constexpr s_sprite_inputs = std::array{
+      sprite_attribute{0u, 2, offsetof(sprite_instance, position)},
+      sprite_attribute{1u, 2, offsetof(sprite_instance, size)},
+      sprite_attribute{2u, 4, offsetof(sprite_instance, color)},
+      sprite_attribute{3u, 4, offsetof(sprite_instance, uv)},
+      sprite_attribute{4u, 1, offsetof(sprite_instance, rotation)},
+  };
+} // namespace
+auto engine::renderer::sprite_batch::add(primitive shape, std::span<instance const> values, uint32_t texture, uint32_t program) -> void
+{
+  m_staged.reserve(m_staged.size() + values.size());
+  for (auto const &value : values) m_staged.push_back({{program, texture, shape}, value});
+}
+auto engine::renderer::sprite_batch::flush(renderer &owner) -> void
+{
+  if (m_staged.empty()) return;
+  if (not std::ranges::is_sorted(m_staged, std::ranges::less{}, &staged::key)) std::ranges::stable_sort(m_staged, std::ranges::less{}, &staged::key);
+  reserve(owner, m_staged.size());
+  auto      &state = owner.state;
+  auto const first = m_segment * m_capacity + m_used;
+  auto const bytes = static_cast<GLsizeiptr>(m_staged.size() * sizeof(instance));
+  state.bind_buffer(GL_ARRAY_BUFFER, m_buffer.name);
+#if /* */ defined(__EMSCRIPTEN__)
+  m_upload.resize(m_staged.size());
+  std::ranges::copy(m_staged | std::views::transform(&staged::value), m_upload.begin());
+  glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(instance)), bytes, m_upload.data());
+#else  // defined(__EMSCRIPTEN__)
+  /* unsynchronized, the segment was fenced free in `reserve` and the range is fresh this frame */
+  auto const mapped = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(instance)), bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  runtime_assert(mapped, "{} stream map fail", "sprite batch");
+  std::ranges::copy(m_staged | std::views::transform(&staged::value), static_cast<instance *>(mapped));
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+#endif // defined(__EMSCRIPTEN__)
+  for (auto const run : m_staged | std::views::chunk_by([](staged const &a, staged const &b) static { return a.key == b.key; }))
+  {
+    auto const &key     = run.front().key;
+    auto const  program = key.program ? key.program : default_program(owner);
+    if (not owner.programs.is_ready(program)) continue; /* the built in program links asynchronously, its failures are reported by `poll` */
+    if (m_runs == m_vertex_arrays.size())
+    {
+      state.bind_vertex_array(m_vertex_arrays.emplace_back(owner.vertexarrays.acquire()).name);
+      for (auto const &input : s_sprite_inputs) glEnableVertexAttribArray(input.location), glVertexAttribDivisor(input.location, 1);
+    }
+    auto const vertex_array = m_vertex_arrays.at(m_runs++).name;
+    auto const run_offset   = (first + static_cast<size_t>(&run.front() - m_staged.data())) * sizeof(instance);
+    state.bind_vertex_array(vertex_array);
+    for (auto const &[location, components, offset] : s_sprite_inputs)
+      glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(sizeof(instance)), reinterpret_cast<void const *>(run_offset + offset));
+    auto const &uniform  = locations(program);
+    auto const  triangle = key.shape == primitive::triangle;
+    auto const  textures = std::array{command_list::texture_binding{.unit = 0u, .target = GL_TEXTURE_2D, .texture = key.texture}};
+    auto const  uniforms = std::array{
+        command_list::uniform_binding{.location = uniform.shape /*    */, .value = GLint{triangle}},
+        command_list::uniform_binding{.location = uniform.textured /* */, .value = GLint{key.texture != 0u}},
+    };
+    owner.commands.record({
+        .program      = program,
+        .vertex_array = vertex_array,
+        .textures     = key.texture ? std::span{textures} : std::span<command_list::texture_binding const>{},
+        .uniforms     = uniforms,
+        .command      = command_list::draw_arrays{
+                 .mode      = static_cast<GLenum>(triangle ? GL_TRIANGLES : GL_TRIANGLE_STRIP),
+                 .first     = 0,
+                 .count     = triangle ? 3 : 4,
+                 .instances = static_cast<GLsizei>(std::ranges::distance(run)),
+        },
+    });
+    m_statistics.draws++;
+  }
+  glCheckError();
+  m_used                 += m_staged.size();
+  m_statistics.instances += m_staged.size();
+  m_statistics.flushes++;
+  m_staged.clear();
+}
+auto engine::renderer::sprite_batch::end_frame(renderer &owner) -> void
+{
+  m_runs = 0zu;
+  m_locations.clear();
+  for (auto const buffer : std::exchange(m_retired, {})) owner.buffers.release(buffer); /* submitted draws keep the storage alive */
+  if (m_used == 0zu) return;
+#if /* */ not defined(__EMSCRIPTEN__) /* sub data uploads are ordered by the browser */
+  m_fences.at(m_segment) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif // not defined(__EMSCRIPTEN__)
+  m_segment = (m_segment + 1zu) % s_ring_size;
+  m_used    = 0zu;
+}
+auto engine::renderer::sprite_batch::reserve(renderer &owner, size_t count) -> void
+{
+  if (m_used + count > m_capacity)
+  {
+    auto const capacity = std::bit_ceil(std::max({count, m_capacity * 2zu, s_initial_capacity}));
+    if (m_buffer.name) m_retired.push_back(std::exchange(m_buffer, {})), m_statistics.growths++; /* runs recorded earlier this frame still read it */
+    for (auto &fence : m_fences)
+      if (fence) glDeleteSync(std::exchange(fence, {}));
+    m_buffer = owner.buffers.acquire();
+    owner.state.bind_buffer(GL_ARRAY_BUFFER, m_buffer.name);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(s_ring_size * capacity * sizeof(instance)), nullptr, GL_STREAM_DRAW);
+    glCheckError();
+    m_capacity = capacity;
+    m_segment  = 0zu;
+    m_used     = 0zu;
+  }
+  if (auto &fence = m_fences.at(m_segment); m_used == 0zu and fence)
+  {
+    if (auto const status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        status != GL_ALREADY_SIGNALED and status != GL_CONDITION_SATISFIED)
+    {
+      glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::chrono::nanoseconds{std::chrono::seconds{1}}.count());
+      m_statistics.fence_waits++;
+    }
+    glDeleteSync(std::exchange(fence, {}));
+  }
+}
+auto engine::renderer::sprite_batch::locations(uint32_t program) -> uniform_locations const &
+{
+  if (auto const it = std::ranges::find(m_locations, program, &uniform_locations::program); it != m_locations.end()) return *it;
+  return m_locations.push_back({
+             .program  = program,
+             .shape    = glGetUniformLocation(program, "sprite_primitive"),
+             .textured = glGetUniformLocation(program, "sprite_textured"),
+         }),
+         m_locations.back();
+}
+auto engine::renderer::sprite_batch::default_program(renderer &owner) -> uint32_t
+{
+  if (m_program) return m_program;
+  auto static constexpr version  = std::string_view{R"glsl(
+    #version 300 es
+    precision highp float;
+  )glsl"};
+  auto static constexpr vertex   = std::string_view{R"glsl(
+    #include "engine/sprite_batch.glsl"
+    out vec4 fragment_color;
+    out vec2 fragment_texcoord;
+    void main()
+    {
+      gl_Position       = sprite_clip_position();
+      fragment_color    = sprite_color;
+      fragment_texcoord = sprite_texcoord();
+    }
+  )glsl"};
+  auto static constexpr fragment = std::string_view{R"glsl(
+    in      vec4      fragment_color;
+    in      vec2      fragment_texcoord;
+    out     vec4      color;
+    uniform sampler2D sprite_texture;
+    uniform bool      sprite_textured;
+    void main()
+    {
+      color = fragment_color * (sprite_textured ? texture(sprite_texture, fragment_texcoord) : vec4(1.0f));
+    }
+  )glsl"};
+  return m_program = owner.shaders.acquire(owner.programs, std::array{version, vertex}, std::array{version, fragment}, {});
+}
+auto engine::renderer::sprite_batch::release(renderer &owner) -> void
+{
+  for (auto &fence : m_fences)
+    if (fence) glDeleteSync(std::exchange(fence, {}));
+  for (auto const vertex_array : std::exchange(m_vertex_arrays, {})) owner.vertexarrays.release(vertex_array);
+  for (auto const buffer : std::exchange(m_retired, {})) owner.buffers.release(buffer);
+  if (m_buffer.name) owner.buffers.release(std::exchange(m_buffer, {}));
+  if (m_program) owner.programs.release(std::exchange(m_program, 0u), owner.state);
+  m_staged.clear();
+  m_locations.clear();
+  m_capacity = m_segment = m_used = m_runs = 0zu;
+}
+
+auto engine::renderer::shader_variants::add_include(std::string name, std::string source) -> void
+{
+  m_includes.insert_or_assign(std::move(name), std::move(source));
+  m_permutations.clear(); /* expansions may have used the previous source */
+}
+auto engine::renderer::shader_variants::acquire(program_cache &programs, std::span<std::string_view const> vertex_sources, std::span<std::string_view const> fragment_sources, std::span<define const> defines) -> uint32_t
+{
+  auto static constexpr is_identifier = [](std::string_view name) static
+  {
+    auto static constexpr is_word = [](char c) static { return std::isalnum(static_cast<unsigned char>(c)) or c == '_'; };
+    return not name.empty() and not std::isdigit(static_cast<unsigned char>(name.front())) and std::ranges::all_of(name, is_word);
+  };
+  auto sorted = std::vector<define>{std::from_range, defines};
+  std::ranges::sort(sorted, std::ranges::less{}, &define::name);
+  for (auto const &[name, value] : sorted)
+  {
+    runtime_assert<std::invalid_argument>(is_identifier(name) and not name.starts_with("GL_"), "invalid shader define name {:?}", name);
+    runtime_assert<std::invalid_argument>(not value.contains('\n'), "shader define {:?} spans lines", name);
+  }
+  if (auto const duplicate = std::ranges::adjacent_find(sorted, std::ranges::equal_to{}, &define::name); duplicate != sorted.end())
+    runtime_assert<std::invalid_argument>(false, "duplicate shader define {:?}", duplicate->name);
+  auto key = program_cache::hash_sources(vertex_sources, fragment_sources);
+  for (auto const &[name, value] : sorted) key = utilities::hash_fnv1a(value, utilities::hash_fnv1a(std::string_view{"\0", 1zu}, utilities::hash_fnv1a(name, key)));
+  auto it = m_permutations.find(key);
+  if (it == m_permutations.end())
+  {
+    it = m_permutations.emplace(key, std::array{expand(vertex_sources, sorted), expand(fragment_sources, sorted)}).first;
+    m_statistics.expansions++;
+  }
+  else m_statistics.hits++;
+  auto const vertex   = std::string_view{it->second[0]};
+  auto const fragment = std::string_view{it->second[1]};
+  return programs.acquire_async(std::span{&vertex, 1zu}, std::span{&fragment, 1zu});
+}
+auto engine::renderer::shader_variants::expand(std::span<std::string_view const> sources, std::span<define const> defines) const -> std::string
+{
+  runtime_assert(not sources.empty(), "can not expand a shader from no sources");
+  auto const first   = sources.front();
+  auto const version = first.find("#version");
+  runtime_assert(version != std::string_view::npos, "Shader must start with a #version directive: \n{}", first);
+  auto const line_end = std::min(first.find('\n', version), first.size());
+  auto       result   = std::string{first.substr(0zu, line_end)} + '\n';
+  auto       included = std::vector<std::string_view>{};
+  for (auto const &[name, value] : defines) std::format_to(std::back_inserter(result), "#define {} {}\n", name, value);
+  resolve(first.substr(std::min(line_end + 1zu, first.size())), result, included);
+  for (auto const source : sources | std::views::drop(1)) resolve(source, result, included);
+  return result;
+}
+auto engine::renderer::shader_variants::find_include(std::string_view name) const -> std::string_view
+{
+  if (auto const it = m_includes.find(std::string{name}); it != m_includes.end()) return it->second;
+  if (auto const it = std::ranges::find(s_builtin_includes, name, [](auto const &include) static { return include.first; }); it != s_builtin_includes.end()) return it->second;
+  return runtime_assert(false, "unknown shader include {:?}", name), std::string_view{};
+}
+auto engine::renderer::shader_variants::resolve(std::string_view source, std::string &target, std::vector<std::string_view> &included) const -> void
+{
+  for (auto const range : source | std::views::split('\n'))
+  {
+    auto const line      = std::string_view{range};
+    auto const directive = line.substr(std::min(line.find_first_not_of(" \t"), line.size()));
+    if (not directive.starts_with("#include"))
+    {
+      target += line;
+      target += '\n';
+      continue;
+    }
+    auto const open  = directive.find_first_of("\"<");
+    auto const close = open == std::string_view::npos ? open : directive.find_first_of("\">", open + 1zu);
+    runtime_assert(close != std::string_view::npos, "malformed shader include {:?}", line);
+    auto const name = directive.substr(open + 1zu, close - open - 1zu);
+    if (std::ranges::contains(included, name)) continue; /* once per stage, which also ends include cycles */
+    included.push_back(name);
+    resolve(find_include(name), target, included);
+  }
+}
@@ -0,0 +1,217 @@
+#include <engine/stats_sink.hpp>
+
+auto engine::utilities::stats_sink::table::publish(std::initializer_list<entry> entries) noexcept -> void
+{
+  if (not m_state) return;
+  auto &state = *m_state;
+  if (not state.named.load(std::memory_order_relaxed))
+  {
+    state.names  = std::vector<std::string_view>{std::from_range, entries | std::views::transform(&entry::name)};
+    state.values = std::make_unique<std::atomic<uint64_t>[]>(entries.size());
+    state.kinds  = std::make_unique<std::atomic<kind>[]>(entries.size());
+    state.named.store(true, std::memory_order_release);
+  }
+  if (state.names.size() != entries.size()) return; /* columns are fixed by the first publish */
+  auto const sequence = state.sequence.load(std::memory_order_relaxed);
+  state.sequence.store(sequence + 1u, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (auto i = 0zu; auto const &entry : entries)
+  {
+    state.kinds[i].store(entry.type, std::memory_order_relaxed);
+    state.values[i].store(entry.bits, std::memory_order_relaxed);
+    i++;
+  }
+  state.sequence.store(sequence + 2u, std::memory_order_release);
+}
+namespace
+{
+  auto json_string(std::string_view value) -> std::string
+  {
+    auto result = std::string{"\""};
+    for (auto const c : value)
+    {
+      switch (c)
+      {
+        case '"' /*  */: result += "\\\""; break;
+        case '\\' /* */: result += "\\\\"; break;
+        case '\b' /* */: result += "\\b"; break;
+        case '\f' /* */: result += "\\f"; break;
+        case '\n' /* */: result += "\\n"; break;
+        case '\r' /* */: result += "\\r"; break;
+        case '\t' /* */: result += "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20u) std::format_to(std::back_inserter(result), "\\u{:04x}", static_cast<unsigned char>(c));
+          else result += c;
+      }
+    }
+    return result += '"';
+  }
+  auto csv_field(std::string_view value) -> std::string
+  {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) return std::string{value};
+    auto result = std::string{"\""};
+    for (auto const c : value) result += c == '"' ? std::string_view{"\"\""} : std::string_view{&c, 1zu};
+    return result += '"';
+  }
+} // namespace
+engine::utilities::stats_sink::stats_sink() {} /* the render thread waits for a table and an output, see `start` */
+engine::utilities::stats_sink::~stats_sink()
+{
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_thread = {};
+#endif // not defined(__EMSCRIPTEN__)
+}
+auto engine::utilities::stats_sink::make_table(std::string title) -> table
+{
+  auto state   = std::make_shared<table_state>();
+  state->title = std::move(title);
+  auto lock    = std::unique_lock{m_mutex};
+  std::erase_if(m_tables, [](auto const &weak) static { return weak.expired(); });
+  m_tables.push_back(state);
+  start(lock);
+  return table{std::move(state)};
+}
+auto engine::utilities::stats_sink::set_output(format value, std::filesystem::path const &path) -> void
+{
+  auto lock    = std::unique_lock{m_mutex};
+  m_format     = value;
+  m_file       = path.empty() ? std::ofstream{} : std::ofstream{path};
+  m_csv_header = false;
+  runtime_assert(path.empty() or m_file, "could not open stats output {}", path.string());
+  start(lock);
+}
+auto engine::utilities::stats_sink::set_period(duration value) -> void
+{
+  auto lock     = std::scoped_lock{m_mutex};
+  m_period      = value;
+  m_next_render = clock::now();
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_wake.notify_all(); /* the thread may be sleeping towards the old deadline */
+#endif // not defined(__EMSCRIPTEN__)
+}
+auto engine::utilities::stats_sink::start(std::unique_lock<std::mutex> &lock) -> void
+{
+  (void)lock; /* held by the caller, the thread blocks on it until then */
+#if /* */ not defined(__EMSCRIPTEN__)
+  if (m_format == format::none or m_tables.empty() or m_thread.joinable()) return;
+  m_thread = std::jthread{[this](std::stop_token stop)
+                          {
+                            auto lock = std::unique_lock{m_mutex};
+                            while (not stop.stop_requested())
+                            {
+                              auto const deadline = m_next_render; /* moved earlier by `set_period` */
+                              m_wake.wait_until(lock, stop, deadline, [this, deadline] { return m_next_render != deadline; });
+                              if (stop.stop_requested()) break;
+                              if (clock::now() >= m_next_render) render(lock);
+                            }
+                          }};
+#endif // not defined(__EMSCRIPTEN__)
+}
+auto engine::utilities::stats_sink::poll() -> void
+{
+#if /* */ defined(__EMSCRIPTEN__)
+  auto lock = std::unique_lock{m_mutex};
+  if (clock::now() >= m_next_render) render(lock);
+#endif // defined(__EMSCRIPTEN__)
+}
+auto engine::utilities::stats_sink::flush() -> void
+{
+  auto lock = std::unique_lock{m_mutex};
+  render(lock);
+}
+auto engine::utilities::stats_sink::render(std::unique_lock<std::mutex> &lock) -> void
+{
+  (void)lock; /* held by the caller */
+  m_next_render = clock::now() + std::chrono::duration_cast<clock::duration>(m_period);
+  if (m_format == format::none) return;
+  auto const time = duration{clock::now() - m_epoch}.count();
+  auto const trim = [](std::string_view name) static
+  { return name.substr(std::min(name.find_first_not_of(' '), name.size())); };
+
+  struct snapshot_t
+  {
+      std::shared_ptr<table_state>      state  = {}; /* kept alive while rendering, the publisher may drop it meanwhile */
+      std::vector<print_table_column_t> values = {};
+  };
+  auto snapshots = std::vector<snapshot_t>{};
+  std::erase_if(m_tables, [](auto const &weak) static { return weak.expired(); });
+  for (auto const &weak : m_tables)
+  {
+    auto state = weak.lock();
+    if (not state or not state->named.load(std::memory_order_acquire)) continue;
+    auto /*  */ snapshot  = snapshot_t{.state = std::move(state)};
+    auto const &state_ref = *snapshot.state;
+    auto const  columns   = state_ref.names.size();
+    for ([[maybe_unused]] auto const attempt : std::views::iota(0, 4))
+    {
+      auto const before = state_ref.sequence.load(std::memory_order_acquire);
+      if (before == 0u or before % 2u) continue;
+      snapshot.values.clear();
+      for (auto const i : std::views::iota(0zu, columns))
+      {
+        auto const bits = state_ref.values[i].load(std::memory_order_relaxed);
+        switch (state_ref.kinds[i].load(std::memory_order_relaxed))
+        {
+          case kind::signed_integer /*   */: snapshot.values.emplace_back(static_cast<int64_t>(bits)); break;
+          case kind::unsigned_integer /* */: snapshot.values.emplace_back(bits); break;
+          case kind::floating_point /*   */: snapshot.values.emplace_back(std::bit_cast<double>(bits)); break;
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (state_ref.sequence.load(std::memory_order_relaxed) == before) break;
+      snapshot.values.clear();
+    }
+    if (not snapshot.values.empty()) snapshots.push_back(std::move(snapshot));
+  }
+  auto const format_value = [](print_table_column_t const &column)
+  { return std::visit([]<typename T>(T const &value) { return std::format("{}", value); }, column.variant); };
+  auto const json_value = [&format_value](print_table_column_t const &column) /* json has no nan or infinity */
+  {
+    auto const *const real = std::get_if<double_t>(&column.variant);
+    return real and not std::isfinite(*real) ? std::string{"null"} : format_value(column);
+  };
+  switch (m_format)
+  {
+    case format::none: break;
+    case format::ansi_table:
+    {
+      auto lines = std::vector<std::array<print_table_column_t, 2zu>>{};
+      for (auto const &snapshot : snapshots)
+      {
+        lines.push_back({"        title", std::string_view{snapshot.state->title}});
+        for (auto const &[name, value] : std::views::zip(snapshot.state->names, snapshot.values))
+          lines.push_back({name, value});
+      }
+      auto const spans = std::vector<std::span<print_table_column_t const>>{std::from_range, lines | std::views::transform(static_cast_lambda<std::span<print_table_column_t const>>)};
+      print_ansi_table_from_spans(spans);
+      break;
+    }
+    case format::csv:
+    case format::jsonl:
+    {
+      auto lines = std::string{};
+      if (m_format == format::csv and not snapshots.empty() and not std::exchange(m_csv_header, true)) lines = "time,table,column,value\n";
+      for (auto const &snapshot : snapshots)
+      {
+        auto const &state = *snapshot.state;
+        if (m_format == format::csv)
+        {
+          auto const table = csv_field(state.title);
+          for (auto const &[name, value] : std::views::zip(state.names, snapshot.values))
+            std::format_to(std::back_inserter(lines), "{:.6f},{},{},{}\n", time, table, csv_field(trim(name)), format_value(value));
+        }
+        else
+        {
+          std::format_to(std::back_inserter(lines), "{{\"time\":{:.6f},\"title\":{}", time, json_string(state.title));
+          for (auto const &[name, value] : std::views::zip(state.names, snapshot.values))
+            std::format_to(std::back_inserter(lines), ",{}:{}", json_string(trim(name)), json_value(value));
+          lines += "}\n";
+        }
+      }
+      if (m_file.is_open()) std::print(m_file, "{}", lines);
+      else std::print("{}", lines);
+      if (m_file.is_open()) m_file.flush();
+      break;
+    }
+  }
+}
@@ -0,0 +1,121 @@
+#include <engine/task.hpp>
+
+#include <GLFW/glfw3.h>
+
+auto engine::task_promise_base::frame_resource() noexcept -> std::pmr::memory_resource &
+{
+  /* frames of a kind share a size, pooling them keeps a coroutine per frame off the general heap */
+  auto static resource = std::pmr::synchronized_pool_resource{std::pmr::pool_options{.max_blocks_per_chunk = 64zu, .largest_required_pool_block = 4096zu}};
+  return resource;
+}
+auto engine::coroutine_scheduler::delay_awaiter::await_suspend(std::coroutine_handle<> handle) const -> void
+{
+  scheduler->m_delayed.emplace_back(deadline, handle);
+  std::ranges::push_heap(scheduler->m_delayed, std::ranges::greater{}, &delayed_t::first);
+}
+auto engine::coroutine_scheduler::gpu_fence_awaiter::await_ready() const noexcept -> bool
+{
+  auto const status = glClientWaitSync(sync, 0, 0);
+  return status == GL_ALREADY_SIGNALED or status == GL_CONDITION_SATISFIED or status == GL_WAIT_FAILED;
+}
+engine::coroutine_scheduler::~coroutine_scheduler() { clear(); }
+auto engine::coroutine_scheduler::clear() -> void
+{
+#if /* */ not defined(__EMSCRIPTEN__)
+  m_workers = {}; /* queued jobs run to the end first, they point into the frames destroyed below */
+#endif // not defined(__EMSCRIPTEN__)
+  for (auto const &[sync, handle] : m_fences) glDeleteSync(sync);
+  m_jobs.clear();
+  m_next_frame.clear();
+  m_delayed.clear();
+  m_fences.clear();
+  m_from_workers.clear();
+  m_tasks.clear();
+}
+auto engine::coroutine_scheduler::spawn(task<void> value) -> void
+{
+  auto const handle = value.get_handle();
+  m_tasks.push_back(std::move(value));
+  if (handle) handle.resume();
+}
+auto engine::coroutine_scheduler::resume_due() -> void
+{
+#if /* */ defined(__EMSCRIPTEN__) /* no worker threads, jobs run here */
+  for (auto jobs = std::exchange(m_jobs, {}); auto &job : jobs) job();
+#endif // defined(__EMSCRIPTEN__)
+  for (auto const handle : std::exchange(m_next_frame, {})) handle.resume();
+  for (auto const now = clock::now(); not m_delayed.empty() and m_delayed.front().first <= now;)
+  {
+    std::ranges::pop_heap(m_delayed, std::ranges::greater{}, &delayed_t::first);
+    auto const handle = m_delayed.back().second;
+    m_delayed.pop_back();
+    handle.resume();
+  }
+  if (not m_fences.empty())
+  {
+    auto signaled = std::vector<std::coroutine_handle<>>{};
+    std::erase_if(m_fences, [&signaled](auto const &fence)
+                  {
+                    auto const status = glClientWaitSync(fence.first, 0, 0);
+                    if (status != GL_ALREADY_SIGNALED and status != GL_CONDITION_SATISFIED and status != GL_WAIT_FAILED) return false;
+                    return signaled.push_back(fence.second), true;
+                  });
+    for (auto const handle : signaled) handle.resume();
+  }
+  auto from_workers = std::vector<std::coroutine_handle<>>{};
+  {
+    auto lock = std::scoped_lock{m_mutex};
+    from_workers.swap(m_from_workers);
+  }
+  for (auto const handle : from_workers) handle.resume();
+  for (auto &value : m_tasks) /* finished tasks report their errors and go */
+  {
+    if (not value.is_done()) continue;
+    try
+    {
+      value.get_handle().promise().get_result();
+    }
+    catch (std::exception const &e)
+    {
+      std::println(stderr, "Error in {:?}: {}", "Coroutine task", e.what());
+    }
+    value = {};
+  }
+  std::erase_if(m_tasks, [](task<void> const &value) static { return not value.get_handle(); });
+}
+auto engine::coroutine_scheduler::next_deadline() const -> std::optional<clock::time_point>
+{
+  if (not m_next_frame.empty() or not m_fences.empty()) return clock::now(); /* fences are polled, keep the loop turning */
+  if (not m_delayed.empty()) return m_delayed.front().first;
+  return std::nullopt;
+}
+auto engine::coroutine_scheduler::submit(std::function<void()> job) -> void
+{
+  auto lock = std::scoped_lock{m_mutex};
+  m_jobs.push_back(std::move(job));
+#if /* */ not defined(__EMSCRIPTEN__)
+  if (m_workers.empty())
+    for ([[maybe_unused]] auto const _ : std::views::iota(0u, std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1u))
+      m_workers.emplace_back([this](std::stop_token stop)
+                             {
+                               auto lock = std::unique_lock{m_mutex};
+                               while (m_wake.wait(lock, stop, [this] { return not m_jobs.empty(); }))
+                               {
+                                 auto job = std::move(m_jobs.front());
+                                 m_jobs.pop_front();
+                                 lock.unlock();
+                                 job();
+                                 lock.lock();
+                               }
+                             });
+  m_wake.notify_one();
+#endif // not defined(__EMSCRIPTEN__)
+}
+auto engine::coroutine_scheduler::resume_on_main(std::coroutine_handle<> handle) -> void
+{
+  {
+    auto lock = std::scoped_lock{m_mutex};
+    m_from_workers.push_back(handle);
+  }
+  glfwPostEmptyEvent(); /* the main loop may be waiting for events */
+}
@@ -1,8 +1,12 @@
 #include <engine/utilities.hpp>
 
-#if /* */ defined(ftell64) or defined(fseek64)
+#if /* */ __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif // __has_include(<cxxabi.h>)
+
+#if /* */ defined(ftell64) or defined(fseek64) or defined(ENGINE_MAPPED_FILE_MMAP)
 #error "Macro name collision"
-#endif //  defined(ftell64) or defined(fseek64)
+#endif //  defined(ftell64) or defined(fseek64) or defined(ENGINE_MAPPED_FILE_MMAP)
 
 #if /* */ defined(_WIN32) or defined(_WIN64)
 #define ftell64 ::_ftelli64
@@ -12,7 +16,15 @@
 #define fseek64 ::fseeko
 #endif // defined(_WIN32) or defined(_WIN64)
 
-auto engine::utilities::print_ansi_table_from_spans(std::span<std::span<print_table_column_t const> const> const lines) -> void
+#if /* */ not defined(_WIN32) and not defined(_WIN64) and not defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ENGINE_MAPPED_FILE_MMAP
+#endif // not defined(_WIN32) and not defined(_WIN64) and not defined(__EMSCRIPTEN__)
+
+auto engine::utilities::print_ansi_table_from_spans(std::span<std::span<print_table_column_t const> const> const lines, std::FILE *stream) -> void
 {
   auto str_buf = std::array<char, 0x01'00zu * print_table_lines_inline_buffer_count>{};
   auto str_mbr = std::pmr::monotonic_buffer_resource{str_buf.data(), str_buf.size()};
@@ -47,16 +59,44 @@ auto engine::utilities::print_ansi_table_from_spans(std::span<std::span<print_ta
 #if /* */ defined(EMSCRIPTEN)
   std::format_to(std::back_inserter(str), "\r\n");
 #endif // defined(EMSCRIPTEN)
-  std::print("\033[s{}\033[u", str);
+  std::print(stream, "\033[s{}\033[u", str);
 }
-auto engine::utilities::print_ansi_table(std::initializer_list<std::initializer_list<print_table_column_t>> lines) -> void
+auto engine::utilities::print_ansi_table(std::initializer_list<std::initializer_list<print_table_column_t>> lines, std::FILE *stream) -> void
 {
   using lines_spans_value_t = std::span<print_table_column_t const>;
   alignas(lines_spans_value_t) auto
              lines_buf   = std::array<std::byte, sizeof(lines_spans_value_t) * print_table_lines_inline_buffer_count>{};
   auto       lines_mbr   = std::pmr::monotonic_buffer_resource{lines_buf.data(), lines_buf.size()};
   auto const lines_spans = std::pmr::vector<lines_spans_value_t>{std::from_range, lines | std::views::transform(static_cast_lambda<lines_spans_value_t>), &lines_mbr};
-  print_ansi_table_from_spans(lines_spans);
+  print_ansi_table_from_spans(lines_spans, stream);
+}
+auto engine::utilities::frame_arena::arena::reset(size_t new_capacity) -> void
+{
+  resource.reset(); /* hands spilled blocks back upstream */
+  if (new_capacity != capacity) buffer = std::make_unique_for_overwrite<std::byte[]>(capacity = new_capacity);
+  upstream.bytes = 0zu;
+  resource.emplace(buffer.get(), capacity, &upstream);
+}
+engine::utilities::frame_arena::frame_arena()
+{
+  for (auto &arena : m_arenas) arena.reset(s_initial_capacity);
+}
+auto engine::utilities::frame_arena::begin_frame() -> void
+{
+  m_current   = (m_current + 1zu) % m_arenas.size();
+  auto &arena = m_arenas.at(m_current);
+  if (arena.upstream.bytes == 0zu) return arena.resource->release();
+  arena.reset(std::bit_ceil(arena.capacity + arena.upstream.bytes)); /* steady state fits without spilling */
+}
+auto engine::utilities::demangle(char const *const name) -> std::string
+{
+#if /* */ __has_include(<cxxabi.h>)
+  auto status    = 0;
+  auto demangled = std::unique_ptr<char, decltype([](char *p) static
+                                                  { std::free(p); })>{abi::__cxa_demangle(name, nullptr, nullptr, &status)};
+  if (status == 0 and demangled) return demangled.get();
+#endif // __has_include(<cxxabi.h>)
+  return name;
 }
 auto engine::utilities::read_all(char const *const file_path, char const *const mode) -> std::expected<std::string, std::error_code>
 {
@@ -76,4 +116,36 @@ auto engine::utilities::read_all(char const *const file_path, char const *const
     return {std::move(str)};
   else
     return std::unexpected{std::error_code{errno, std::generic_category()}};
-}
\ No newline at end of file
+}
+
+engine::utilities::mapped_file::~mapped_file()
+{
+#if /* */ defined(ENGINE_MAPPED_FILE_MMAP)
+  if (m_mapped) ::munmap(const_cast<std::byte *>(m_data), m_size);
+#endif // defined(ENGINE_MAPPED_FILE_MMAP)
+}
+auto engine::utilities::mapped_file::open(std::filesystem::path const &file_path) -> std::expected<mapped_file, std::error_code>
+{
+  auto result = mapped_file{};
+#if /* */ defined(ENGINE_MAPPED_FILE_MMAP)
+  auto const descriptor = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) return std::unexpected{std::error_code{errno, std::generic_category()}};
+  auto const descriptor_ptr = std::unique_ptr<int const, decltype([](int const *p) static { ::close(*p); })>{&descriptor};
+  struct ::stat status;
+  if (::fstat(descriptor, &status) != 0) return std::unexpected{std::error_code{errno, std::generic_category()}};
+  if (status.st_size == 0) return result; /* nothing to map, and mapping zero bytes fails */
+  auto const address = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+  if (address == MAP_FAILED) return std::unexpected{std::error_code{errno, std::generic_category()}};
+  ::posix_madvise(address, static_cast<size_t>(status.st_size), POSIX_MADV_SEQUENTIAL);
+  result.m_data   = static_cast<std::byte const *>(address);
+  result.m_size   = static_cast<size_t>(status.st_size);
+  result.m_mapped = true;
+#else  // defined(ENGINE_MAPPED_FILE_MMAP)
+  auto bytes = read_all(file_path, "rb");
+  if (not bytes) return std::unexpected{bytes.error()};
+  result.m_fallback = std::move(*bytes);
+  result.m_data     = reinterpret_cast<std::byte const *>(result.m_fallback.data());
+  result.m_size     = result.m_fallback.size();
+#endif // defined(ENGINE_MAPPED_FILE_MMAP)
+  return result;
+}
@@ -15,7 +15,9 @@ namespace game
 namespace game::layers
 {
   using engine::application;
-  using layer = application::layer;
+  using layer        = application::layer;
+  using command_list = engine::renderer::command_list;
+  using stats_table  = engine::utilities::stats_sink::table;
 
   struct clear;
   struct boids;
@@ -58,9 +60,9 @@ struct game::layers::clear : layer
     /**/ clear() noexcept = default;
     auto on_render() -> void override
     {
-      glClearColor(color.r, color.g, color.b, color.a);
-      glClear(GL_COLOR_BUFFER_BIT);
+      app().get_renderer().commands.record({.command = command_list::clear{.mask = GL_COLOR_BUFFER_BIT, .color = color}});
     }
+    auto is_dirty() const -> bool override { return false; }
 };
 template <>
 auto inline game::layers::push_layer<game::layers::clear>(bool game_layers, engine::application &app) -> void
@@ -0,0 +1,100 @@
+#ifndef GAME_SIMULATIONS_HPP
+#define GAME_SIMULATIONS_HPP
+
+#include <engine/core.hpp>
+#include <engine/utilities.hpp>
+
+/* Cpu side of the game simulations, free of gl and of the application so they can be stepped by the benchmarks */
+namespace game::simulations
+{
+  using engine::utilities::runtime_assert;
+
+  struct boids
+  {
+    public:
+      struct settings
+      {
+          float min_position      = -1.0f,
+                max_position      = +1.0f,
+                min_velocity      = +0.1f,
+                max_velocity      = +0.5f,
+                min_acceleration  = +0.1f,
+                max_acceleration  = +2.0f;
+          float view_distance     = +0.1f,
+                boid_width        = view_distance / 4.0f;
+          float weight_separation = +0.02f,
+                weight_alignment  = +1.2f,
+                weight_cohesion   = +1.3f,
+                weight_mouse_flee = +100.0f;
+          size_t tick_rate        = 60zu,
+                 boid_count       = 800zu,
+                 max_neighbors    = 16zu;
+          auto inline subspace_width() const noexcept { return view_distance; }
+          auto inline subspace_count() const noexcept { return static_cast<glm::i32>(glm::ceil((max_position - min_position) / subspace_width())); }
+
+        public:
+          auto /*  */ validate() const -> void
+          {
+            auto static constexpr verify_sorted = [](std::string_view const name, auto const &values) static
+            { return runtime_assert(std::ranges::is_sorted(values), "invalid {:?}", name); };
+            verify_sorted("position limits" /*     */, std::array{-1.0f /*    */, min_position /*      */, max_position /*      */, +001.0f});
+            verify_sorted("velocity limits" /*     */, std::array{+0.0f /*    */, min_velocity /*      */, max_velocity /*      */, +100.0f});
+            verify_sorted("acceleration limits" /* */, std::array{+0.0f /*    */, min_acceleration /*  */, max_acceleration /*  */, +010.0f});
+            verify_sorted("view distance" /*       */, std::array{+0.0f /*    */, view_distance /*     */, max_position /*      */});
+            verify_sorted("boid width" /*          */, std::array{+0.0f /*    */, boid_width /*        */, view_distance /*     */});
+            verify_sorted("weight separation" /*   */, std::array{+0.0001f /* */, weight_separation /* */, +10.0f /*            */});
+            verify_sorted("weight alignment" /*    */, std::array{+0.0001f /* */, weight_alignment /*  */, +10.0f /*            */});
+            verify_sorted("weight cohesion" /*     */, std::array{+0.0001f /* */, weight_cohesion /*   */, +10.0f /*            */});
+            verify_sorted("tick rate" /*           */, std::array{1zu /*      */, tick_rate /*         */, 60zu /*              */});
+            verify_sorted("boid count" /*          */, std::array{1zu /*      */, boid_count /*        */, 9'999zu /*           */});
+            verify_sorted("max neighbors" /*       */, std::array{1zu /*      */, max_neighbors /*     */, boid_count /*        */});
+          }
+      };
+      struct boid
+      {
+          uint32_t              id{}, padding{};
+          glm::vec2             position{}, velocity{}, acceleration{};
+          auto inline constexpr operator<=>(boid const &o) const noexcept -> auto { return id <=> o.id; }
+      };
+      struct step_statistics
+      {
+          size_t total_neighbors = 0zu, /* connections, each counted once */
+                 max_neighbors   = 0zu,
+                 subspaces       = 0zu;
+      };
+
+      /**/ inline boids() : boids(settings{}, 0u) {}
+      /**/ inline boids(settings const &config, uint64_t seed) : m_settings{(config.validate(), config)} { reset(seed); }
+
+      /* drops the flock, the next step spawns `boid_count` boids from `seed` */
+      auto /*  */ reset(uint64_t seed) -> void;
+      /* one tick of `1 / tick_rate` seconds, boids within reach of `mouse_position` flee it */
+      auto /*  */ step(glm::vec2 mouse_position) -> step_statistics;
+
+      auto inline get_settings /* */ () const noexcept -> settings const & { return m_settings; }
+      auto inline get_boids /*    */ () const noexcept -> std::span<boid const> { return m_boids; }
+
+    private:
+      auto inline static constexpr hash_vec = []<glm::length_t L, typename T>(glm::vec<L, T> const p)
+      {
+        auto res = 0zu;
+        for (auto const hash = std::hash<T>{}; auto const i : std::views::iota(glm::length_t{0}, L))
+          res = res xor hash(p[i]);
+        return res;
+      };
+      using subspace_id               = glm::i32vec2;
+      using boids_grouped_by_subspace = std::unordered_map<subspace_id, std::vector<boid>, decltype(hash_vec)>;
+      using distance                  = float;
+      using boid_distance_pairs       = std::vector<std::pair<boid, distance>>;
+
+      auto random(float min = -1.0f, float max = 1.0f) -> float { return std::uniform_real_distribution{min, max}(m_random); }
+
+      settings /*                  */ m_settings                   = {};
+      std::vector<boid> /*         */ m_boids                      = {};
+      boids_grouped_by_subspace /* */ m_subspaces_allocation_cache = {};
+      boid_distance_pairs /*       */ m_neighbors_allocation_cache = {};
+      std::mt19937 /*              */ m_random                     = {}; /* seeded by `reset`, replays spawn the same flock */
+  };
+} // namespace game::simulations
+
+#endif // GAME_SIMULATIONS_HPP
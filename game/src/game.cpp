@@ -24,6 +24,7 @@ struct game::layers::keyboard_control_later : engine::application::layer
       push_layer("keyboard_control_later", false, app());
       push_layer(layers.at(next_game_i), true, app());
     }
+    auto is_dirty() const -> bool override { return false; }
 };
 template <>
 auto game::layers::push_layer<game::layers::keyboard_control_later>(bool game_layers, engine::application &app) -> void
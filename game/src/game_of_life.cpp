@@ -1,3 +1,4 @@
+#include <engine/events.hpp>
 #include <game/game.hpp>
 
 struct game::layers::game_of_life : layer
@@ -11,6 +12,8 @@ struct game::layers::game_of_life : layer
         double /*    */ init_distribution = 30.0;
         glm::vec4 /* */ color_alive       = {0.0f, 0.8f, 0.6f, 1.0f},
                         color_dead        = {0.0f, 0.0f, 0.0f, 1.0f};
+        uint32_t /*  */ rule_birth        = 1u << 3u,               /* bit n set: a dead cell with n live neighbors is born */
+                        rule_survival     = 1u << 2u | 1u << 3u;    /* bit n set: a live cell with n live neighbors lives on */
 
       public:
         auto validate() const -> void
@@ -21,15 +24,15 @@ struct game::layers::game_of_life : layer
           verify_sorted("height" /*            */, std::array{4zu, height /*            */, 0x04'00zu});
           verify_sorted("tick rate" /*         */, std::array{1zu, tick_rate /*         */, 60zu});
           verify_sorted("init distribution" /* */, std::array{0.0, init_distribution /* */, 100.0});
+          verify_sorted("rule birth" /*        */, std::array{0u, rule_birth /*        */, 0x1'FFu});
+          verify_sorted("rule survival" /*     */, std::array{0u, rule_survival /*     */, 0x1'FFu});
         }
     };
     struct opengl_handles
     {
-        uint32_t vao{}, tid0{}, tid1{}, fbo0{}, fbo1{}, vid{}, fid{}, pid{};
-    };
-    struct uniform_locations
-    {
-        int32_t tex = -1, tex_size = -1, print = -1, color_alive = -1, color_dead = -1;
+        using unique_handle = engine::renderer::handle_cache::unique_handle;
+        unique_handle vao{}, tid0{}, tid1{}, fbo0{}, fbo1{};
+        uint32_t /**/ step_pid{}, print_pid{}; /* variants of one template, the settings are baked in */
     };
     struct statistics
     {
@@ -43,43 +46,36 @@ struct game::layers::game_of_life : layer
     /**/ game_of_life() : game_of_life(simulation_settings{}) {}
     /**/ game_of_life(simulation_settings const &settings) : m_settings{(settings.validate(), settings)}
     {
-      m_handles.vao /*  */ = app().get_renderer().vertexarrays /* */.activate();
-      m_handles.tid0 /* */ = app().get_renderer().textures /*     */.activate();
-      m_handles.tid1 /* */ = app().get_renderer().textures /*     */.activate();
-      m_handles.fbo0 /* */ = app().get_renderer().framebuffers /* */.activate();
-      m_handles.fbo1 /* */ = app().get_renderer().framebuffers /* */.activate();
-      m_handles.vid /*  */ = glCreateShader(GL_VERTEX_SHADER);
-      m_handles.fid /*  */ = glCreateShader(GL_FRAGMENT_SHADER);
-      m_handles.pid /*  */ = glCreateProgram();
+      m_handles.vao /*  */ = app().get_renderer().vertexarrays /* */.make_unique();
+      m_handles.tid0 /* */ = app().get_renderer().textures /*     */.make_unique();
+      m_handles.tid1 /* */ = app().get_renderer().textures /*     */.make_unique();
+      m_handles.fbo0 /* */ = app().get_renderer().framebuffers /* */.make_unique();
+      m_handles.fbo1 /* */ = app().get_renderer().framebuffers /* */.make_unique();
       setup();
     }
     /**/ ~game_of_life()
     {
-      m_handles.vao /*  */ = (app().get_renderer().vertexarrays /* */.deactivate(m_handles.vao /*  */), 0u);
-      m_handles.tid0 /* */ = (app().get_renderer().textures /*     */.deactivate(m_handles.tid0 /* */), 0u);
-      m_handles.tid1 /* */ = (app().get_renderer().textures /*     */.deactivate(m_handles.tid1 /* */), 0u);
-      m_handles.fbo0 /* */ = (app().get_renderer().framebuffers /* */.deactivate(m_handles.fbo0 /* */), 0u);
-      m_handles.fbo1 /* */ = (app().get_renderer().framebuffers /* */.deactivate(m_handles.fbo1 /* */), 0u);
-      m_handles.vid /*  */ = (glDeleteShader(m_handles.vid), 0u);
-      m_handles.fid /*  */ = (glDeleteShader(m_handles.fid), 0u);
-      m_handles.pid /*  */ = (glDeleteProgram(m_handles.pid), 0u);
+      for (auto *const pid : {&m_handles.step_pid, &m_handles.print_pid})
+        *pid = (app().get_renderer().programs.release(*pid, app().get_renderer().state), 0u);
     }
 
   private:
     auto setup() -> void
     {
-      glBindVertexArray(m_handles.vao);
+      auto &state = app().get_renderer().state;
+      state.bind_vertex_array(m_handles.vao.get());
       glCheckError();
 
-      auto       cell_rd        = std::random_device{};
+      auto       cell_seed      = std::seed_seq{static_cast<uint32_t>(app().get_seed()), static_cast<uint32_t>(app().get_seed() >> 32u), 0x11FEu};
+      auto       cell_rd        = std::mt19937{cell_seed};
       auto       cell_dist      = std::uniform_real_distribution{0.0, 100.0};
       auto const cell_threshold = m_settings.init_distribution;
-      for (auto const &[tid, fbo] : {std::pair{m_handles.tid0, m_handles.fbo0},
-                                     std::pair{m_handles.tid1, m_handles.fbo1}})
+      for (auto const &[tid, fbo] : {std::pair{m_handles.tid0.get(), m_handles.fbo0.get()},
+                                     std::pair{m_handles.tid1.get(), m_handles.fbo1.get()}})
       {
         auto const width  = static_cast<GLsizei>(m_settings.width);
         auto const height = static_cast<GLsizei>(m_settings.height);
-        glBindTexture(GL_TEXTURE_2D, tid);
+        state.bind_texture(0u, GL_TEXTURE_2D, tid);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -93,55 +89,114 @@ struct game::layers::game_of_life : layer
         glTexImage2D(GL_TEXTURE_2D, /* level */ 0, GL_R8, width, height, /* border */ 0, GL_RED, GL_UNSIGNED_BYTE, subpixels.data());
         glCheckError();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        state.bind_framebuffer(GL_FRAMEBUFFER, fbo);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tid, /* level */ 0);
         runtime_assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
         glCheckError();
       }
 
-      app().get_renderer().compile_shader(m_handles.vid, std::array{m_glsl_version, m_glsl_vertex});
-      app().get_renderer().compile_shader(m_handles.fid, std::array{m_glsl_version, m_glsl_fragment});
-      app().get_renderer().link_program(m_handles.pid, std::array{m_handles.vid, m_handles.fid});
+      using shader_variants = engine::renderer::shader_variants;
+      auto &renderer        = app().get_renderer();
+      for (auto const [pid, print] : {std::pair{&m_handles.step_pid, 0}, std::pair{&m_handles.print_pid, 1}})
+      {
+        auto const defines = std::array{
+            shader_variants::make_define("PRINT" /*         */, print),
+            shader_variants::make_define("TEX_SIZE" /*      */, glm::ivec2{m_settings.width, m_settings.height}),
+            shader_variants::make_define("COLOR_ALIVE" /*   */, m_settings.color_alive),
+            shader_variants::make_define("COLOR_DEAD" /*    */, m_settings.color_dead),
+            shader_variants::make_define("RULE_BIRTH" /*    */, m_settings.rule_birth),
+            shader_variants::make_define("RULE_SURVIVAL" /* */, m_settings.rule_survival),
+        };
+        *pid = renderer.shaders.acquire(renderer.programs, std::array{m_glsl_version, m_glsl_vertex}, std::array{m_glsl_version, m_glsl_fragment}, defines);
+      }
 
-      m_uniforms = {
-          .tex         = glGetUniformLocation(m_handles.pid, "tex" /*         */),
-          .tex_size    = glGetUniformLocation(m_handles.pid, "tex_size" /*    */),
-          .print       = glGetUniformLocation(m_handles.pid, "print" /*       */),
-          .color_alive = glGetUniformLocation(m_handles.pid, "color_alive" /* */),
-          .color_dead  = glGetUniformLocation(m_handles.pid, "color_dead" /*  */),
-      };
+      state.bind_framebuffer(GL_FRAMEBUFFER, 0u);
+      glCheckError();
 
-      m_tick = 0zu;
+      m_tick        = 0zu;
+      m_render_tick = ~0zu;
+    }
+    auto program_ready() const -> bool
+    {
+      auto const &programs = app().get_renderer().programs;
+      return programs.is_ready(m_handles.step_pid) and programs.is_ready(m_handles.print_pid);
+    }
+    /* raw files of width * height bytes (255 alive) upload straight from the mapping, anything else is read as plaintext `.cells` */
+    auto load_pattern(engine::utilities::mapped_file const &file) -> void
+    {
+      auto const width  = m_settings.width;
+      auto const height = m_settings.height;
+      auto const tid    = m_tick % 2 == 0 ? m_handles.tid0.get() : m_handles.tid1.get();
+      auto      &state  = app().get_renderer().state;
+      auto       cells  = std::vector<uint8_t>{};
+      if (file.size() != width * height)
+      {
+        auto const rows = file.view() | std::views::split('\n') |
+                          std::views::transform([](auto &&range) static
+                                                {
+                                                  auto row = std::string_view{range};
+                                                  return row.ends_with('\r') ? row.substr(0zu, row.size() - 1zu) : row;
+                                                }) |
+                          std::views::filter([](std::string_view row) static { return not row.starts_with('!'); }) |
+                          std::ranges::to<std::vector>();
+        auto const columns = std::ranges::fold_left(rows | std::views::transform([](std::string_view row) static { return row.size(); }), 0zu, std::ranges::max);
+        auto const offset  = glm::ivec2{(static_cast<int>(width) - static_cast<int>(columns)) / 2,
+                                        (static_cast<int>(height) - static_cast<int>(rows.size())) / 2};
+        cells.resize(width * height);
+        for (auto const [row_index, row] : std::views::enumerate(rows))
+          for (auto const [column_index, cell] : std::views::enumerate(row))
+          {
+            auto const x = offset.x + static_cast<int>(column_index);
+            auto const y = offset.y + static_cast<int>(rows.size()) - 1 - static_cast<int>(row_index); /* text rows run top down */
+            if (0 <= x and x < static_cast<int>(width) and 0 <= y and y < static_cast<int>(height) and (cell == 'O' or cell == '*'))
+              cells[static_cast<size_t>(y) * width + static_cast<size_t>(x)] = std::numeric_limits<uint8_t>::max();
+          }
+      }
+      state.bind_texture(0u, GL_TEXTURE_2D, tid);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexSubImage2D(GL_TEXTURE_2D, /* level */ 0, /* offset */ 0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                      GL_RED, GL_UNSIGNED_BYTE, cells.empty() ? static_cast<void const *>(file.data()) : cells.data());
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      glCheckError();
+      m_render_tick = ~0zu;
     }
 
   public:
+    auto on_event(std::any const &event_any) -> void override
+    {
+      auto const event_ptr = std::any_cast<engine::events::drop_event>(&event_any);
+      if (not event_ptr or event_ptr->paths.empty()) return;
+      m_pattern = app().get_file_loader().load(event_ptr->paths.front());
+    }
+
     auto on_update() -> update_delay override
     {
+      if (not program_ready()) return update_delay(1.0) / m_settings.tick_rate;
+      if (engine::utilities::file_loader::is_ready(m_pattern))
+      {
+        if (auto const file = m_pattern.get()) load_pattern(*file);
+        else std::println(stderr, "Error in {:?}: {}", "Pattern load", file.error().message());
+      }
       auto const update_start = std::chrono::steady_clock::now();
       auto const even_tick    = m_tick % 2 == 0;
-      auto const tid          = even_tick ? m_handles.tid0 : m_handles.tid1;
-      auto const fbo          = even_tick ? m_handles.fbo1 : m_handles.fbo0;
+      auto const tid          = even_tick ? m_handles.tid0.get() : m_handles.tid1.get();
+      auto const fbo          = even_tick ? m_handles.fbo1.get() : m_handles.fbo0.get();
+      auto      &state        = app().get_renderer().state;
 
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, tid);
+      state.bind_texture(0u, GL_TEXTURE_2D, tid);
       glCheckError();
 
-      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      state.bind_framebuffer(GL_FRAMEBUFFER, fbo);
       glCheckError();
 
-      glUseProgram(m_handles.pid);
-      glUniform1i(m_uniforms.tex /*         */, 0);
-      glUniform2i(m_uniforms.tex_size /*    */, static_cast<int>(m_settings.width), static_cast<int>(m_settings.height));
-      glUniform1i(m_uniforms.print /*       */, false);
-      glUniform4f(m_uniforms.color_alive /* */, m_settings.color_alive /* */.r, m_settings.color_alive /* */.g, m_settings.color_alive /* */.b, m_settings.color_alive /* */.a);
-      glUniform4f(m_uniforms.color_dead /*  */, m_settings.color_dead /*  */.r, m_settings.color_dead /*  */.g, m_settings.color_dead /*  */.b, m_settings.color_dead /*  */.a);
+      state.use_program(m_handles.step_pid); /* the sampler stays on its default unit 0 */
       glCheckError();
 
-      glBindVertexArray(m_handles.vao);
+      state.bind_vertex_array(m_handles.vao.get());
       glDrawArrays(GL_TRIANGLE_STRIP, /* first */ 0, /* count */ 4);
       glCheckError();
 
-      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      state.bind_framebuffer(GL_FRAMEBUFFER, 0u);
       glCheckError();
 
       auto const update_end                = std::chrono::steady_clock::now();
@@ -151,14 +206,15 @@ struct game::layers::game_of_life : layer
       auto const cycle_duration            = std::chrono::duration_cast<std::chrono::duration<double>>(cycle_end /*  */ - cycle_start /*  */).count();
       m_statistics.average_update_duration = (m_statistics.average_update_duration /* */ * 99.0 + 1.0 * update_duration /* */) / 100.0;
       m_statistics.average_cycle_duration  = (m_statistics.average_cycle_duration /*  */ * 99.0 + 1.0 * cycle_duration /*  */) / 100.0;
-      utilities::print_ansi_table({
-          {"        title", "Game Of Life"},
+      m_stats_table.publish({
           {"         tick", m_tick},
           {"update/cycle%", 0100.0 * m_statistics.average_update_duration / m_statistics.average_cycle_duration},
           {"    ms/update", 1000.0 * m_statistics.average_update_duration},
           {"    ms/ cycle", 1000.0 * m_statistics.average_cycle_duration},
           {"    updates/s", 0001.0 / m_statistics.average_update_duration},
           {"     cycles/s", 0001.0 / m_statistics.average_cycle_duration},
+          {"     gl calls", state.get_frame_counters().issued},
+          {"   gl skipped", state.get_frame_counters().skipped},
       });
 
       m_tick++;
@@ -166,32 +222,30 @@ struct game::layers::game_of_life : layer
     }
     auto on_render() -> void override
     {
+      if (not program_ready()) return;
       auto const even_tick = m_tick % 2 == 0;
-      auto const tid       = even_tick ? m_handles.tid0 : m_handles.tid1;
-
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, tid);
-      glCheckError();
-
-      glUseProgram(m_handles.pid);
-      glUniform1i(m_uniforms.tex /*         */, 0);
-      glUniform2i(m_uniforms.tex_size /*    */, static_cast<int>(m_settings.width), static_cast<int>(m_settings.height));
-      glUniform1i(m_uniforms.print /*       */, true);
-      glUniform4f(m_uniforms.color_alive /* */, m_settings.color_alive /* */.r, m_settings.color_alive /* */.g, m_settings.color_alive /* */.b, m_settings.color_alive /* */.a);
-      glUniform4f(m_uniforms.color_dead /*  */, m_settings.color_dead /*  */.r, m_settings.color_dead /*  */.g, m_settings.color_dead /*  */.b, m_settings.color_dead /*  */.a);
-      glCheckError();
-
-      glBindVertexArray(m_handles.vao);
-      glDrawArrays(GL_TRIANGLE_STRIP, /* first */ 0, /* count */ 4);
-      glCheckError();
+      auto const tid       = even_tick ? m_handles.tid0.get() : m_handles.tid1.get();
+      auto const textures  = std::array{
+          command_list::texture_binding{.unit = 0u, .target = GL_TEXTURE_2D, .texture = tid},
+      };
+      app().get_renderer().commands.record({
+          .program      = m_handles.print_pid,
+          .vertex_array = m_handles.vao.get(),
+          .textures     = textures,
+          .command      = command_list::draw_arrays{.mode = GL_TRIANGLE_STRIP, .first = 0, .count = 4},
+      });
+      m_render_tick = m_tick;
     }
+    auto is_dirty() const -> bool override { return m_render_tick != m_tick; }
 
   private:
-    simulation_settings m_settings   = {};
-    opengl_handles      m_handles    = {};
-    uniform_locations   m_uniforms   = {};
-    statistics          m_statistics = {};
-    size_t              m_tick       = {};
+    simulation_settings /*        */ m_settings    = {};
+    opengl_handles /*             */ m_handles     = {};
+    statistics /*                 */ m_statistics  = {};
+    stats_table /*                */ m_stats_table = app().get_stats().make_table("Game Of Life");
+    size_t /*                     */ m_tick        = {}, m_render_tick = ~0zu;
+    std::future<engine::utilities::file_loader::result_t>
+        /*                        */ m_pattern     = {}; /* dropped on the window, applied by the first update after it loads */
 
   private:
     std::string_view m_glsl_version  = {R"glsl(
@@ -217,20 +271,13 @@ struct game::layers::game_of_life : layer
                      m_glsl_fragment = {R"glsl(
       in      vec2      uv;
       uniform sampler2D tex;
-      uniform ivec2     tex_size;
-      uniform bool      print;
-      uniform vec4      color_alive;
-      uniform vec4      color_dead;
       out     vec4      color;
       void main()
       {
-        if (print)
-        {
-          bool cell_alive = texture(tex, uv).r > 0.5f;
-          color           = cell_alive ? color_alive : color_dead;
-          return;
-        }
-
+      #if PRINT
+        bool cell_alive = texture(tex, uv).r > 0.5f;
+        color           = cell_alive ? COLOR_ALIVE : COLOR_DEAD;
+      #else  // PRINT
         ivec2 pos        = ivec2(gl_FragCoord.xy);
         float cell       = texelFetch(tex, pos, 0).r;
         bool  cell_alive = cell > 0.5f;
@@ -241,15 +288,16 @@ struct game::layers::game_of_life : layer
           for (int j = -1; j <= 1; j++)
           {
             if (i == 0 && j == 0) continue;
-            ivec2 neighbor_pos = (pos + ivec2(i, j)) % tex_size;
+            ivec2 neighbor_pos = (pos + ivec2(i, j)) % TEX_SIZE;
             if (texelFetch(tex, neighbor_pos, 0).r > 0.5f) neighbor_count++;
           }
         }
 
-        cell_alive = cell_alive ? neighbor_count == 2 || neighbor_count == 3
-                                : neighbor_count == 3;
+        uint rule  = cell_alive ? RULE_SURVIVAL : RULE_BIRTH;
+        cell_alive = (rule >> uint(neighbor_count) & 1u) != 0u;
         color      = vec4(cell_alive ? 1.0f : 0.0f);
         color.a    = 1.0f;
+      #endif // PRINT
       }
     )glsl"};
 };
@@ -0,0 +1,126 @@
+#include <game/simulations.hpp>
+
+auto game::simulations::boids::reset(uint64_t seed) -> void
+{
+  auto seed_sequence = std::seed_seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32u), 0xB01D5u};
+  m_random.seed(seed_sequence);
+  m_boids                      = {};
+  m_subspaces_allocation_cache = {};
+  m_neighbors_allocation_cache = {};
+}
+auto game::simulations::boids::step(glm::vec2 mouse_position) -> step_statistics
+{
+  auto const dt               = 1.0f / static_cast<float>(m_settings.tick_rate);
+  auto       total_neighbors  = 0zu;
+  auto       max_neighbors    = 0zu;
+  auto      &subspaces        = m_subspaces_allocation_cache;
+  auto const subspace_offsets = std::views::iota(-1, 1 + 1);
+  auto const subspaces_count  = glm::vec2{static_cast<float>(m_settings.subspace_count())};
+  auto const get_subspace_id  = [subspaces_count](boid const &b) -> subspace_id
+  { return {b.position * subspaces_count}; };
+  if (m_boids.size() != m_settings.boid_count)
+  {
+    auto const old_boid_count = m_boids.size();
+    m_boids.resize(m_settings.boid_count);
+    for (auto &boid : m_boids | std::views::drop(old_boid_count))
+      boid = {
+          .id           = static_cast<decltype(boid.id)>(&boid - m_boids.data()),
+          .position     = glm::vec2{random(), random()} * m_settings.max_position,
+          .velocity     = glm::vec2{random(), random()} * m_settings.min_velocity,
+          .acceleration = glm::vec2{random(), random()} * m_settings.min_acceleration,
+      };
+  }
+  for (auto &[id, boids] : subspaces) boids.clear();
+  for (auto &boid : m_boids) subspaces[get_subspace_id(boid)].push_back(boid);
+  for (auto &boid : m_boids)
+  {
+    auto static constexpr clamp_length = [](glm::vec2 value, float min, float max) -> glm::vec2
+    {
+      auto const len = glm::length(value);
+      if (len < min) value *= min / len;
+      if (len > max) value *= max / len;
+      return value;
+    };
+    auto const &neighbors = [&] -> auto &
+    {
+      auto const subspace_id = get_subspace_id(boid);
+      auto      &neighbors   = m_neighbors_allocation_cache;
+      neighbors.clear();
+      for (auto const y : subspace_offsets)
+        for (auto const x : subspace_offsets)
+          for (auto const skip_self_check = not(x == 0 and y == 0);
+               auto const b : subspaces[subspace_id + glm::i32vec2{x, y}])
+            /**/ if (not skip_self_check and boid.id == b.id)
+              continue;
+            else if (auto const distance = glm::distance(boid.position, b.position);
+                     distance <= m_settings.view_distance + m_settings.boid_width * 0.5f)
+              neighbors.push_back({b, distance});
+      auto static constexpr get_distance_from_pair = &std::remove_reference_t<decltype(neighbors.front())>::second;
+      /**/ if (auto const is_neighbor_drop_needed /*               */ = neighbors.size() <= m_settings.max_neighbors)
+      {
+        (void)is_neighbor_drop_needed;
+        /* goto return statement */;
+      }
+      else if (auto const is_sort_out_greater_distances_cheaper /* */ = neighbors.size() <= m_settings.max_neighbors * 2)
+      {
+        (void)is_sort_out_greater_distances_cheaper;
+        auto const sort_size          = neighbors.size() - m_settings.max_neighbors;
+        auto const sort_comp          = std::ranges::less{};
+        auto const [unsorted, sorted] = engine::utilities::heap_sort_partial(std::span{neighbors}, sort_size, sort_comp, get_distance_from_pair);
+        (void)unsorted, (void)sorted; /* unsorted is already in place */
+        neighbors.resize(m_settings.max_neighbors);
+      }
+      else if (auto const is_sort_in_lesser_distances_cheaper /*   */ = true)
+      {
+        (void)is_sort_in_lesser_distances_cheaper;
+        auto const sort_size          = m_settings.max_neighbors;
+        auto const sort_comp          = std::ranges::greater{};
+        auto const [unsorted, sorted] = engine::utilities::heap_sort_partial(std::span{neighbors}, sort_size, sort_comp, get_distance_from_pair);
+        std::ranges::copy(sorted, neighbors.data()), (void)unsorted;
+        neighbors.resize(m_settings.max_neighbors);
+      }
+      return neighbors;
+    }();
+    auto const [separation, alignment, cohesion] = [&]
+    {
+      if (neighbors.size() == 0zu) return std::tuple{glm::vec2{}, glm::vec2{}, glm::vec2{}};
+      auto total_separation = glm::vec2{},
+           total_velocity   = glm::vec2{},
+           total_position   = glm::vec2{};
+      for (auto const &[b, distance] : neighbors)
+      {
+        total_separation += (boid.position - b.position) / (distance * distance * distance);
+        total_velocity   += b.velocity;
+        total_position   += b.position;
+      }
+      auto const average_separation = total_separation / static_cast<float>(neighbors.size()),
+                 average_velocity   = total_velocity / static_cast<float>(neighbors.size()),
+                 average_position   = total_position / static_cast<float>(neighbors.size());
+      auto const separation         = clamp_length(average_separation /*         */, 0.0f, +m_settings.max_acceleration),
+                 alignment          = clamp_length(average_velocity - boid.velocity, 0.0f, +m_settings.max_acceleration),
+                 cohesion           = clamp_length(average_position - boid.position, 0.0f, +m_settings.max_acceleration);
+      return std::tuple{separation, alignment, cohesion};
+    }();
+    auto const [mouse_flee] = [&]
+    {
+      auto mouse_gap  = boid.position - mouse_position;
+      auto mouse_flee = glm::vec2{};
+      if (glm::length(mouse_gap) < 0.1f) mouse_flee = glm::normalize(mouse_gap) * 10.0f;
+      return std::tuple{mouse_flee};
+    }();
+    total_neighbors   += neighbors.size();
+    max_neighbors      = std::max(max_neighbors, neighbors.size());
+    boid.acceleration += m_settings.weight_separation /* */ * separation /* */ +
+                         m_settings.weight_alignment /*  */ * alignment /*  */ +
+                         m_settings.weight_cohesion /*   */ * cohesion /*   */ +
+                         m_settings.weight_mouse_flee /* */ * mouse_flee /* */;
+    boid.acceleration   = clamp_length(boid.acceleration, m_settings.min_acceleration, m_settings.max_acceleration);
+    boid.velocity      += boid.acceleration * dt;
+    boid.velocity       = clamp_length(boid.velocity, m_settings.min_velocity, m_settings.max_velocity);
+    boid.position      += boid.velocity * dt;
+    auto const clamped  = glm::clamp(boid.position, m_settings.min_position - m_settings.boid_width, m_settings.max_position + m_settings.boid_width);
+    if (boid.position.x != clamped.x) boid.position.x = -clamped.x;
+    if (boid.position.y != clamped.y) boid.position.y = -clamped.y;
+  }
+  return {.total_neighbors = total_neighbors / 2zu, .max_neighbors = max_neighbors, .subspaces = subspaces.size()};
+}
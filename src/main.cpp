@@ -1,8 +1,8 @@
 #include <engine/application.hpp>
 
-int main()
+int main(int argc, char *argv[])
 {
-  auto app = engine::application{};
+  auto app = engine::application{engine::application::options::parse({argv, static_cast<size_t>(argc)})};
   engine::startup(app);
   return app.run();
 }
\ No newline at end of file